@@ -1,6 +1,7 @@
 #ifndef BFS_H
 #define BFS_H
 
+#include "csr.h"
 #include "graph.h"
 
 typedef struct {
@@ -9,6 +10,31 @@ typedef struct {
     List* path;
 } BfsVertex;
 
+/* Reusable state for repeated searches of a frozen graph */
+typedef struct {
+    int vcount;
+    unsigned int stamp;
+    unsigned int* visited;
+    int* frontier;
+    int* dist;
+    int* pred;
+} BfsWorkspace;
+
 int bfs(Graph* graph, BfsVertex* start, List* hops);
 
+int bfs_csr(const CsrGraph* csr, int start, int* hops);
+
+int bfs_workspace_init(BfsWorkspace* workspace, int vcount);
+
+void bfs_workspace_destroy(BfsWorkspace* workspace);
+
+int bfs_visit(BfsWorkspace* workspace, const CsrGraph* csr, int start, int maxdepth,
+              int (*visit)(int vertex, int depth, void* arg), void* arg);
+
+#define bfs_reached(workspace, v) ((workspace)->visited[(v)] == (workspace)->stamp)
+
+#define bfs_dist(workspace, v) ((workspace)->dist[(v)])
+
+#define bfs_pred(workspace, v) ((workspace)->pred[(v)])
+
 #endif
@@ -8,13 +8,72 @@
 #define AVL_BALANCED 0
 #define AVL_RIGHT_HEAVY -1
 
+/* Number of nodes carved from each slab */
+#define AVL_SLAB_NODES 128
+
+/* Default share of hidden nodes that triggers a rebuild */
+#define AVL_THRESHOLD 0.5
+
+/* Lookups advanced together by a batch, one cache miss in flight for each */
+#define AVL_BATCH 16
+
+/* Smallest pair of subtrees a set operation hands to another thread */
+#define AVL_SET_GRAIN 4096
+
+/* Tallest AVL tree possible with fewer than 2^31 nodes */
+#define AVL_MAX_HEIGHT 48
+
+/* Tree node & AVL data in one block, the node's data pointing back at the block */
+/* The count is of live nodes in the subtree, for ranking */
+/* The prefix orders nodes without reaching into the data, unless two prefixes tie */
 typedef struct {
+    BiTreeNode node;
     void* data;
-    int hidden;
-    int factor;
+    unsigned long long prefix;
+    signed char factor;
+    unsigned char hidden;
+    int count;
 } AvlNode;
 
-typedef BiTree BisTree;
+/* Block of nodes allocated at once */
+typedef struct AvlSlab_ {
+    struct AvlSlab_* next;
+    AvlNode nodes[AVL_SLAB_NODES];
+} AvlSlab;
+
+/* Laid out like BiTree up to the root, so the bitree macros apply */
+typedef struct {
+    int size;
+    int (*compare)(const void* key1, const void* key2);
+    void (*destroy)(void* data);
+    BiTreeNode* root;
+    AvlSlab* slabs;
+    int used;
+    AvlNode* free;
+    int hidden;
+    double threshold;
+    unsigned long long (*prefix)(const void* data);
+} BisTree;
+
+/* Position in an in-order walk, holding the path down from the root */
+typedef struct {
+    int depth;
+    const BiTreeNode* path[AVL_MAX_HEIGHT];
+} BisCursor;
+
+/* Read-only copy of the live data, laid out in breadth-first (Eytzinger) order from 1 */
+typedef struct {
+    int size;
+    int (*compare)(const void* key1, const void* key2);
+    void** data;
+} BisFrozen;
+
+/* Shape of a tree at one moment */
+typedef struct {
+    int live;
+    int hidden;
+    int height;
+} BisTreeStats;
 
 void bistree_init(BisTree* tree,
                   int (*compare)(const void* key1, const void* key2),
@@ -28,6 +87,62 @@ int bistree_remove(BisTree* tree, const void* data);
 
 int bistree_lookup(BisTree* tree, void** data);
 
+int bistree_lookup_batch(const BisTree* tree, void* const* keys, int count, void** results);
+
+int bistree_delete(BisTree* tree, void** data);
+
+int bistree_rebuild(BisTree* tree);
+
+void bistree_set_threshold(BisTree* tree, double threshold);
+
+/* Wherever two prefixes differ they must order the data as compare does, else lookups go wrong */
+/* A datum's prefix must not change while it is in the tree; setting a new extractor refills every node */
+void bistree_set_prefix(BisTree* tree, unsigned long long (*prefix)(const void* data));
+
+unsigned long long bistree_string_prefix(const char* key);
+
+void bistree_stats(const BisTree* tree, BisTreeStats* stats);
+
+int bistree_build_sorted(BisTree* tree, void* const* items, int count);
+
+int bistree_merge_sorted(BisTree* tree, void* const* items, int count);
+
+int bistree_freeze(const BisTree* tree, BisFrozen* frozen);
+
+void bistree_frozen_destroy(BisFrozen* frozen);
+
+int bistree_frozen_lookup(const BisFrozen* frozen, void** data);
+
+#define bistree_frozen_size(frozen) ((frozen)->size)
+
+int bistree_seek(const BisTree* tree, BisCursor* cursor, const void* data);
+
+int bistree_seek_last(const BisTree* tree, BisCursor* cursor, const void* data);
+
+int bistree_next(BisCursor* cursor);
+
+int bistree_prev(BisCursor* cursor);
+
+int bistree_rank(const BisTree* tree, const void* data);
+
+int bistree_select(const BisTree* tree, int rank, void** data);
+
+int bistree_range(const BisTree* tree, const void* low, const void* high,
+                  int (*callback)(const void* data, void* arg), void* arg);
+
+/* Set operations initialise result, which must be neither input, & consume both inputs */
+/* The trees must share compare, prefix & destroy, else -1 & both are left as they were */
+/* On success both trees are left empty & result owns all their nodes, destroying entries it drops */
+int bistree_union(BisTree* result, BisTree* tree1, BisTree* tree2, int nthreads);
+
+int bistree_intersect(BisTree* result, BisTree* tree1, BisTree* tree2, int nthreads);
+
+int bistree_difference(BisTree* result, BisTree* tree1, BisTree* tree2, int nthreads);
+
+#define bistree_cursor_data(cursor) (bistree_avl((cursor)->path[(cursor)->depth - 1])->data)
+
 #define bistree_size(tree) ((tree)->size)
 
+#define bistree_avl(node) ((AvlNode*) (node))
+
 #endif
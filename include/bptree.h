@@ -0,0 +1,57 @@
+#ifndef BPTREE_H
+#define BPTREE_H
+
+#include <stdlib.h>
+
+/* Most keys held by one node, a multiple of four for the SIMD search */
+#define BPTREE_ORDER 32
+
+/* Fewest keys a node other than the root may hold */
+#define BPTREE_MIN (BPTREE_ORDER / 2)
+
+/* Leaves hold the data, inner nodes copies of it to separate their children */
+typedef struct BpNode_ {
+    int leaf;
+    int count;
+    int keys[BPTREE_ORDER];
+    void* data[BPTREE_ORDER];
+    struct BpNode_* children[BPTREE_ORDER + 1];
+    struct BpNode_* next;
+} BpNode;
+
+/* Ordered map on a B+tree, searching integer keys when given a key function */
+typedef struct {
+    int size;
+    int (*compare)(const void* key1, const void* key2);
+    int (*key)(const void* data);
+    void (*destroy)(void* data);
+    BpNode* root;
+} BpTree;
+
+/* Position in the chain of leaves */
+typedef struct {
+    const BpNode* leaf;
+    int index;
+} BpCursor;
+
+void bptree_init(BpTree* tree,
+                 int (*compare)(const void* key1, const void* key2),
+                 void (*destroy)(void* data));
+
+void bptree_init_int(BpTree* tree, int (*key)(const void* data), void (*destroy)(void* data));
+
+void bptree_destroy(BpTree* tree);
+
+int bptree_insert(BpTree* tree, const void* data);
+
+int bptree_remove(BpTree* tree, void** data);
+
+int bptree_lookup(const BpTree* tree, void** data);
+
+void bptree_seek(const BpTree* tree, BpCursor* cursor, const void* data);
+
+int bptree_next(BpCursor* cursor, void** data);
+
+#define bptree_size(tree) ((tree)->size)
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef CENTRALITY_H
+#define CENTRALITY_H
+
+#include "csr.h"
+
+int betweenness(const CsrGraph* csr, int samples, unsigned int seed, int nthreads, double* centrality);
+
+#endif
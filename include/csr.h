@@ -0,0 +1,48 @@
+#ifndef CSR_H
+#define CSR_H
+
+#include "graph.h"
+
+/* Frozen graph in compressed sparse row form, vertices numbered 0..vcount-1 */
+/* Each row of neighbours is sorted by number & holds no repeats */
+typedef struct {
+    int vcount;
+    int ecount;
+    int (*match)(const void* key1, const void* key2);
+    void** vertices;
+    int* offsets;
+    int* targets;
+    int* slots;
+    int nslots;
+} CsrGraph;
+
+/* Vertex orderings for relabeling a frozen graph */
+typedef enum { CSR_ORDER_BFS, CSR_ORDER_RCM, CSR_ORDER_DEGREE, CSR_ORDER_HUB } CsrOrder;
+
+int csr_build(CsrGraph* csr, const Graph* graph);
+
+int csr_from_edges(CsrGraph* csr, int vcount, const int* edges, int ecount);
+
+void csr_destroy(CsrGraph* csr);
+
+int csr_transpose(CsrGraph* transposed, const CsrGraph* csr);
+
+int csr_vertex_id(const CsrGraph* csr, const void* data);
+
+int csr_reorder(CsrGraph* reordered, const CsrGraph* csr, CsrOrder order, int* perm, int* iperm);
+
+int csr_intersect(const int* set1, int size1, const int* set2, int size2, int* common);
+
+int csr_common_neighbours(const CsrGraph* csr, int u, int v, int* common);
+
+#define csr_vcount(csr) ((csr)->vcount)
+
+#define csr_ecount(csr) ((csr)->ecount)
+
+#define csr_vertex(csr, v) ((csr)->vertices[(v)])
+
+#define csr_degree(csr, v) ((csr)->offsets[(v) + 1] - (csr)->offsets[(v)])
+
+#define csr_neighbours(csr, v) ((csr)->targets + (csr)->offsets[(v)])
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef DYNBFS_H
+#define DYNBFS_H
+
+#include "csr.h"
+
+/* Growable neighbour array */
+typedef struct {
+    int size;
+    int capacity;
+    int* ids;
+} DynAdj;
+
+/* Single-source hop counts kept up to date under edge updates */
+typedef struct {
+    int vcount;
+    int root;
+    int limit;
+    int changed;
+    int* dist;
+    int* pred;
+    DynAdj* out;
+    DynAdj* in;
+    int* queue;
+    unsigned char* mark;
+} DynBfs;
+
+int dynbfs_init(DynBfs* dynbfs, const CsrGraph* csr, int root, int limit);
+
+void dynbfs_destroy(DynBfs* dynbfs);
+
+int dynbfs_ins_edge(DynBfs* dynbfs, int id1, int id2);
+
+int dynbfs_rem_edge(DynBfs* dynbfs, int id1, int id2);
+
+#define dynbfs_dist(dynbfs, v) ((dynbfs)->dist[(v)])
+
+#define dynbfs_pred(dynbfs, v) ((dynbfs)->pred[(v)])
+
+#define dynbfs_changed(dynbfs) ((dynbfs)->changed)
+
+#endif
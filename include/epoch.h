@@ -0,0 +1,50 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/* Epoch announced by a thread that is not inside a critical section */
+#define EPOCH_IDLE (~0UL)
+
+typedef struct EpochThread_ {
+    atomic_ulong epoch;
+    struct EpochThread_* next;
+} EpochThread;
+
+typedef struct EpochRetired_ {
+    void* data;
+    void (*destroy)(void* data);
+    struct EpochRetired_* next;
+} EpochRetired;
+
+/* Epoch-based reclamation domain shared by readers & writers */
+typedef struct {
+    atomic_ulong global;
+    EpochThread* threads;
+    EpochRetired* retired[3];
+    int pending;
+    pthread_mutex_t lock;
+} EpochDomain;
+
+int epoch_init(EpochDomain* domain);
+
+void epoch_destroy(EpochDomain* domain);
+
+void epoch_register(EpochDomain* domain, EpochThread* thread);
+
+void epoch_unregister(EpochDomain* domain, EpochThread* thread);
+
+void epoch_enter(EpochDomain* domain, EpochThread* thread);
+
+void epoch_exit(EpochThread* thread);
+
+int epoch_retire(EpochDomain* domain, void* data, void (*destroy)(void* data));
+
+/* Retire onto a record the caller allocated with malloc, which cannot fail */
+void epoch_retire_record(EpochDomain* domain, EpochRetired* retired, void* data, void (*destroy)(void* data));
+
+void epoch_reclaim(EpochDomain* domain);
+
+#endif
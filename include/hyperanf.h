@@ -0,0 +1,14 @@
+#ifndef HYPERANF_H
+#define HYPERANF_H
+
+#include "csr.h"
+
+/* Bounds on the log2 of HyperLogLog registers per vertex */
+#define HYPERANF_MIN_LOG2M 4
+#define HYPERANF_MAX_LOG2M 16
+
+int hyperanf_log2m(double error);
+
+int hyperanf(const CsrGraph* csr, int log2m, int maxhops, int nthreads, double* nf, double* reach);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+/* Table giving each distinct name a dense id, counting up from 0 */
+typedef struct {
+    int size;
+    int capacity;
+    int nbuckets;
+    int* buckets;
+    unsigned int* hashes;
+    char** names;
+} InternTable;
+
+int intern_init(InternTable* table);
+
+void intern_destroy(InternTable* table);
+
+int intern_id(InternTable* table, const char* name);
+
+int intern_lookup(const InternTable* table, const char* name);
+
+#define intern_size(table) ((table)->size)
+
+#define intern_name(table, id) ((const char*) (table)->names[(id)])
+
+#endif
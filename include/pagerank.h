@@ -0,0 +1,16 @@
+#ifndef PAGERANK_H
+#define PAGERANK_H
+
+#include "csr.h"
+
+/* Direction in which rank flows along the edges */
+typedef enum { PAGERANK_PULL, PAGERANK_PUSH } PageRankMode;
+
+int spmv_pull(const CsrGraph* transposed, const double* x, double* y, int nthreads);
+
+int spmv_push(const CsrGraph* csr, const double* x, double* y, int nthreads);
+
+int pagerank(const CsrGraph* csr, double damping, double tolerance, int maxiter,
+             PageRankMode mode, int nthreads, double* rank);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+typedef struct {
+    int n;
+    int grain;
+    atomic_int next;
+    void (*body)(int begin, int end, int thread, void* arg);
+    void* arg;
+} ParallelLoop;
+
+typedef struct ParallelWorker_ {
+    ParallelLoop* loop;
+    int thread;
+    struct ParallelPool_* pool;
+} ParallelWorker;
+
+/* Worker threads kept alive across many loops, so each loop costs a wakeup */
+typedef struct ParallelPool_ {
+    int nthreads;
+    int active;
+    int stop;
+    unsigned long generation;
+    ParallelLoop loop;
+    pthread_t* threads;
+    ParallelWorker* workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+} ParallelPool;
+
+int parallel_threads(int nthreads);
+
+int parallel_for(int n, int grain, int nthreads,
+                 void (*body)(int begin, int end, int thread, void* arg), void* arg);
+
+int parallel_pool_init(ParallelPool* pool, int nthreads);
+
+void parallel_pool_destroy(ParallelPool* pool);
+
+void parallel_pool_for(ParallelPool* pool, int n, int grain,
+                       void (*body)(int begin, int end, int thread, void* arg), void* arg);
+
+#define parallel_pool_threads(pool) ((pool)->nthreads)
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef PBFS_H
+#define PBFS_H
+
+#include "csr.h"
+
+/* Upper bound on worker processes for one search */
+#define PBFS_MAX_PARTS 64
+
+/* How vertices are dealt out to partitions */
+typedef enum { PBFS_RANGE, PBFS_HASH } PbfsPartition;
+
+/* Work & traffic for one level of a partitioned search */
+typedef struct {
+    long frontier;
+    long edges;
+    long messages;
+    long bytes;
+} PbfsLevel;
+
+typedef struct {
+    int nparts;
+    int nlevels;
+    PbfsLevel* levels;
+} PbfsStats;
+
+int pbfs(const CsrGraph* csr, int start, int nparts, PbfsPartition partition, int* hops, PbfsStats* stats);
+
+void pbfs_stats_destroy(PbfsStats* stats);
+
+#endif
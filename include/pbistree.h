@@ -0,0 +1,56 @@
+#ifndef PBISTREE_H
+#define PBISTREE_H
+
+#include "epoch.h"
+
+/* Tallest AVL tree possible with fewer than 2^31 nodes */
+#define PBISTREE_MAX_HEIGHT 48
+
+/* Most nodes one update can create or replace */
+#define PBISTREE_SCRATCH (4 * PBISTREE_MAX_HEIGHT)
+
+/* Node that never changes once published */
+typedef struct PbisNode_ {
+    void* data;
+    const struct PbisNode_* left;
+    const struct PbisNode_* right;
+    int height;
+} PbisNode;
+
+/* Persistent AVL tree, updated by copying paths & read through pinned roots */
+typedef struct {
+    int size;
+    int (*compare)(const void* key1, const void* key2);
+    void (*destroy)(void* data);
+    _Atomic(const PbisNode*) root;
+    pthread_mutex_t writer;
+    EpochDomain epoch;
+    int ncreated;
+    int nreplaced;
+    const PbisNode* created[PBISTREE_SCRATCH];
+    const PbisNode* replaced[PBISTREE_SCRATCH];
+} PbisTree;
+
+int pbistree_init(PbisTree* tree,
+                  int (*compare)(const void* key1, const void* key2),
+                  void (*destroy)(void* data));
+
+void pbistree_destroy(PbisTree* tree);
+
+int pbistree_insert(PbisTree* tree, const void* data);
+
+int pbistree_remove(PbisTree* tree, const void* data);
+
+void pbistree_attach(PbisTree* tree, EpochThread* reader);
+
+void pbistree_detach(PbisTree* tree, EpochThread* reader);
+
+const PbisNode* pbistree_pin(PbisTree* tree, EpochThread* reader);
+
+void pbistree_unpin(EpochThread* reader);
+
+int pbistree_lookup(const PbisTree* tree, const PbisNode* root, void** data);
+
+#define pbistree_size(tree) ((tree)->size)
+
+#endif
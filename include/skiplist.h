@@ -0,0 +1,62 @@
+#ifndef SKIPLIST_H
+#define SKIPLIST_H
+
+#include <stdint.h>
+#include "epoch.h"
+
+/* Most levels a node can have, enough for far more than 2^31 entries */
+#define SKIPLIST_MAX_LEVEL 32
+
+/* Bits of a node's state, the last to set one of them retires the node */
+#define SKIPLIST_LINKED 1
+#define SKIPLIST_REMOVED 2
+
+/* Node of a lock-free skip list, each link's low bit marking the node as removed */
+typedef struct SkipNode_ {
+    void* data;
+    int level;
+    atomic_int state;
+    _Atomic(uintptr_t) next[];
+} SkipNode;
+
+/* Ordered map that any number of threads can update at once */
+typedef struct {
+    atomic_int size;
+    int (*compare)(const void* key1, const void* key2);
+    void (*destroy)(void* data);
+    SkipNode* head;
+    EpochDomain epoch;
+} SkipList;
+
+int skiplist_init(SkipList* list,
+                  int (*compare)(const void* key1, const void* key2),
+                  void (*destroy)(void* data));
+
+void skiplist_destroy(SkipList* list);
+
+void skiplist_attach(SkipList* list, EpochThread* thread);
+
+void skiplist_detach(SkipList* list, EpochThread* thread);
+
+int skiplist_insert(SkipList* list, EpochThread* thread, const void* data);
+
+int skiplist_remove(SkipList* list, EpochThread* thread, const void* data);
+
+/* With a destroy callback, data passed back is only safe to use until the thread unpins */
+/* Pin around the lookup & every use of its result; lookups inside a pin leave it in place */
+int skiplist_lookup(SkipList* list, EpochThread* thread, void** data);
+
+void skiplist_pin(SkipList* list, EpochThread* thread);
+
+void skiplist_unpin(EpochThread* thread);
+
+/* Seek & next walk nodes that may be retired at any time, so call them only while pinned */
+const SkipNode* skiplist_seek(const SkipList* list, const void* data);
+
+const SkipNode* skiplist_next(const SkipNode* node);
+
+#define skiplist_size(list) (atomic_load(&(list)->size))
+
+#define skiplist_data(node) ((node)->data)
+
+#endif
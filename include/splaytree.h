@@ -0,0 +1,24 @@
+#ifndef SPLAYTREE_H
+#define SPLAYTREE_H
+
+#include "bitree.h"
+
+/* Self-adjusting search tree, each access moving its node to the root */
+/* Lookups change the shape, so even readers need exclusive access */
+typedef BiTree SplayTree;
+
+void splaytree_init(SplayTree* tree,
+                    int (*compare)(const void* key1, const void* key2),
+                    void (*destroy)(void* data));
+
+void splaytree_destroy(SplayTree* tree);
+
+int splaytree_insert(SplayTree* tree, const void* data);
+
+int splaytree_remove(SplayTree* tree, void** data);
+
+int splaytree_lookup(SplayTree* tree, void** data);
+
+#define splaytree_size(tree) ((tree)->size)
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef TRIANGLE_H
+#define TRIANGLE_H
+
+#include "csr.h"
+
+long triangle_count(const CsrGraph* csr, int nthreads, long* per_vertex);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef TST_H
+#define TST_H
+
+#include <stdlib.h>
+
+/* Node of a ternary search tree, linked to its neighbours by index */
+typedef struct {
+    unsigned char split;
+    unsigned char end;
+    int low;
+    int equal;
+    int high;
+    void* data;
+} TstNode;
+
+/* Index of strings to data, searched one character at a time */
+typedef struct {
+    int size;
+    int count;
+    int capacity;
+    void (*destroy)(void* data);
+    TstNode* nodes;
+} Tst;
+
+void tst_init(Tst* tst, void (*destroy)(void* data));
+
+void tst_destroy(Tst* tst);
+
+int tst_insert(Tst* tst, const char* key, const void* data);
+
+int tst_remove(Tst* tst, const char* key, void** data);
+
+int tst_lookup(const Tst* tst, const char* key, void** data);
+
+int tst_longest_prefix(const Tst* tst, const char* key, void** data);
+
+int tst_prefix(const Tst* tst, const char* prefix,
+               int (*callback)(const void* data, void* arg), void* arg);
+
+#define tst_size(tst) ((tst)->size)
+
+#endif
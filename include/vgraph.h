@@ -0,0 +1,62 @@
+#ifndef VGRAPH_H
+#define VGRAPH_H
+
+#include "csr.h"
+#include "epoch.h"
+
+/* Number of adjacency records per chunk of a version */
+#define VGRAPH_CHUNK 256
+
+/* Immutable adjacency record of one vertex */
+typedef struct {
+    void* vertex;
+    int degree;
+    int targets[];
+} VGraphAdj;
+
+typedef struct {
+    VGraphAdj* adj[VGRAPH_CHUNK];
+} VGraphChunk;
+
+/* Immutable snapshot of the whole graph */
+typedef struct {
+    int vcount;
+    int ecount;
+    int nchunks;
+    VGraphChunk** chunks;
+} VGraphVersion;
+
+/* Copy-on-write versioned graph */
+typedef struct {
+    _Atomic(VGraphVersion*) current;
+    pthread_mutex_t writer;
+    EpochDomain epoch;
+} VGraph;
+
+int vgraph_init(VGraph* vgraph, const CsrGraph* csr);
+
+void vgraph_destroy(VGraph* vgraph);
+
+int vgraph_ins_vertex(VGraph* vgraph, const void* data);
+
+int vgraph_ins_edge(VGraph* vgraph, int id1, int id2);
+
+int vgraph_rem_edge(VGraph* vgraph, int id1, int id2);
+
+void vgraph_attach(VGraph* vgraph, EpochThread* reader);
+
+void vgraph_detach(VGraph* vgraph, EpochThread* reader);
+
+const VGraphVersion* vgraph_pin(VGraph* vgraph, EpochThread* reader);
+
+void vgraph_unpin(EpochThread* reader);
+
+int vgraph_bfs(const VGraphVersion* version, int start, int* hops);
+
+#define vgraph_vcount(version) ((version)->vcount)
+
+#define vgraph_ecount(version) ((version)->ecount)
+
+#define vgraph_adj(version, v) ((version)->chunks[(v) / VGRAPH_CHUNK]->adj[(v) % VGRAPH_CHUNK])
+
+#endif
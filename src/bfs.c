@@ -1,3 +1,4 @@
+#include <string.h>
 #include "../include/bfs.h"
 #include "../include/queue.h"
 
@@ -104,3 +105,130 @@ int bfs(Graph* graph, BfsVertex* start, List* hops) {
 
     return 0;
 }
+
+int bfs_csr(const CsrGraph* csr, int start, int* hops) {
+    int* queue;
+    const int* adj;
+    int head, tail, u, i;
+
+    if (start < 0 || start >= csr_vcount(csr)) {
+        return -1;
+    }
+
+    queue = malloc(csr_vcount(csr) * sizeof(int));
+    if (!queue) {
+        return -1;
+    }
+
+    /* Unreached vertices keep a hop count of -1 */
+    for (i = 0; i < csr_vcount(csr); i++) {
+        hops[i] = -1;
+    }
+
+    hops[start] = 0;
+    queue[0] = start;
+    head = 0;
+    tail = 1;
+
+    /* Perform a breadth-first search over the contiguous neighbour arrays */
+    while (head < tail) {
+        u = queue[head++];
+        adj = csr_neighbours(csr, u);
+
+        for (i = 0; i < csr_degree(csr, u); i++) {
+            if (hops[adj[i]] < 0) {
+                hops[adj[i]] = hops[u] + 1;
+                queue[tail++] = adj[i];
+            }
+        }
+    }
+
+    free(queue);
+    return 0;
+}
+
+int bfs_workspace_init(BfsWorkspace* workspace, int vcount) {
+    workspace->vcount = vcount;
+    workspace->stamp = 0;
+    workspace->visited = calloc(vcount ? vcount : 1, sizeof(unsigned int));
+    workspace->frontier = malloc((vcount ? vcount : 1) * sizeof(int));
+    workspace->dist = malloc((vcount ? vcount : 1) * sizeof(int));
+    workspace->pred = malloc((vcount ? vcount : 1) * sizeof(int));
+
+    if (!workspace->visited || !workspace->frontier || !workspace->dist || !workspace->pred) {
+        bfs_workspace_destroy(workspace);
+        return -1;
+    }
+
+    return 0;
+}
+
+void bfs_workspace_destroy(BfsWorkspace* workspace) {
+    free(workspace->visited);
+    free(workspace->frontier);
+    free(workspace->dist);
+    free(workspace->pred);
+    memset(workspace, 0, sizeof(BfsWorkspace));
+}
+
+int bfs_visit(BfsWorkspace* workspace, const CsrGraph* csr, int start, int maxdepth,
+              int (*visit)(int vertex, int depth, void* arg), void* arg) {
+    unsigned int* visited;
+    const int* adj;
+    int head, tail, u, w, i;
+
+    if (start < 0 || start >= csr_vcount(csr) || csr_vcount(csr) > workspace->vcount) {
+        return -1;
+    }
+
+    /* Start a new generation instead of clearing every vertex */
+    workspace->stamp += 1;
+    if (!workspace->stamp) {
+        memset(workspace->visited, 0, workspace->vcount * sizeof(unsigned int));
+        workspace->stamp = 1;
+    }
+
+    visited = workspace->visited;
+    visited[start] = workspace->stamp;
+    workspace->dist[start] = 0;
+    workspace->pred[start] = -1;
+
+    if (visit && visit(start, 0, arg)) {
+        return 1;
+    }
+
+    workspace->frontier[0] = start;
+    head = 0;
+    tail = 1;
+
+    while (head < tail) {
+        u = workspace->frontier[head++];
+
+        /* Vertices at the depth limit are reached but not expanded */
+        if (maxdepth >= 0 && workspace->dist[u] >= maxdepth) {
+            continue;
+        }
+
+        adj = csr_neighbours(csr, u);
+
+        for (i = 0; i < csr_degree(csr, u); i++) {
+            w = adj[i];
+            if (visited[w] == workspace->stamp) {
+                continue;
+            }
+
+            visited[w] = workspace->stamp;
+            workspace->dist[w] = workspace->dist[u] + 1;
+            workspace->pred[w] = u;
+
+            /* Let the visitor end the search as soon as it has its answer */
+            if (visit && visit(w, workspace->dist[w], arg)) {
+                return 1;
+            }
+
+            workspace->frontier[tail++] = w;
+        }
+    }
+
+    return 0;
+}
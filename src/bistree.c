@@ -1,22 +1,84 @@
 #include "../include/bistree.h"
+#include <pthread.h>
 #include <string.h>
 
 static void destroy_right(BisTree* tree, BiTreeNode* node);
 
+static unsigned long long key_prefix(const BisTree* tree, const void* data) {
+    return tree->prefix ? tree->prefix(data) : 0;
+}
+
+static BiTreeNode* alloc_node(BisTree* tree, const void* data) {
+    AvlSlab* slab;
+    AvlNode* avl_node;
+
+    if (tree->free) {
+        /* Reuse a node given back to the tree */
+        avl_node = tree->free;
+        tree->free = (AvlNode*) bitree_right(&avl_node->node);
+    }
+    else {
+        if (!tree->slabs || tree->used == AVL_SLAB_NODES) {
+            slab = (AvlSlab*) malloc(sizeof(AvlSlab));
+            if (!slab) {
+                return NULL;
+            }
+
+            slab->next = tree->slabs;
+            tree->slabs = slab;
+            tree->used = 0;
+        }
+
+        avl_node = &tree->slabs->nodes[tree->used++];
+    }
+
+    avl_node->node.data = avl_node;
+    avl_node->node.left = NULL;
+    avl_node->node.right = NULL;
+    avl_node->data = (void*) data;
+    avl_node->prefix = key_prefix(tree, data);
+    avl_node->factor = AVL_BALANCED;
+    avl_node->hidden = 0;
+    avl_node->count = 1;
+
+    return &avl_node->node;
+}
+
+static int count_live(const BiTreeNode* node) {
+    return bitree_is_eob(node) ? 0 : bistree_avl(node)->count;
+}
+
+static int order(const BisTree* tree, const void* data, unsigned long long prefix, const BiTreeNode* node) {
+    /* Settle the order from the prefixes alone unless they tie */
+    if (prefix != bistree_avl(node)->prefix) {
+        return prefix < bistree_avl(node)->prefix ? -1 : 1;
+    }
+
+    return tree->compare(data, bistree_avl(node)->data);
+}
+
+static void update(BiTreeNode* node) {
+    /* Recount the live nodes below from the children's counts */
+    bistree_avl(node)->count = count_live(bitree_left(node)) + count_live(bitree_right(node))
+                               + !bistree_avl(node)->hidden;
+}
+
 static void rotate_left(BiTreeNode** node) {
     BiTreeNode* left;
     BiTreeNode* grandchild;
 
     left = bitree_left(*node);
 
-    if (((AvlNode*) bitree_data(left))->factor == AVL_LEFT_HEAVY) {
+    if (bistree_avl(left)->factor == AVL_LEFT_HEAVY) {
         /* Perform an LL rotation */
         bitree_left(*node) = bitree_right(left);
         bitree_right(left) = *node;
 
-        ((AvlNode*) bitree_data(*node))->factor = AVL_BALANCED;
-        ((AvlNode*) bitree_data(left))->factor = AVL_BALANCED;
+        bistree_avl(*node)->factor = AVL_BALANCED;
+        bistree_avl(left)->factor = AVL_BALANCED;
 
+        update(*node);
+        update(left);
         *node = left;
     }
     else {
@@ -27,24 +89,28 @@ static void rotate_left(BiTreeNode** node) {
         bitree_left(*node) = bitree_right(grandchild);
         bitree_right(grandchild) = *node;
 
-        switch (((AvlNode*) bitree_data((grandchild)))->factor) {
+        switch (bistree_avl(grandchild)->factor) {
             case AVL_LEFT_HEAVY:
-                ((AvlNode*) bitree_data(*node))->factor = AVL_RIGHT_HEAVY;
-                ((AvlNode*) bitree_data(left))->factor = AVL_BALANCED;
+                bistree_avl(*node)->factor = AVL_RIGHT_HEAVY;
+                bistree_avl(left)->factor = AVL_BALANCED;
                 break;
 
             case AVL_BALANCED:
-                ((AvlNode*) bitree_data(*node))->factor = AVL_BALANCED;
-                ((AvlNode*) bitree_data(left))->factor = AVL_BALANCED;
+                bistree_avl(*node)->factor = AVL_BALANCED;
+                bistree_avl(left)->factor = AVL_BALANCED;
                 break;
 
             case AVL_RIGHT_HEAVY:
-                ((AvlNode*) bitree_data(*node))->factor = AVL_BALANCED;
-                ((AvlNode*) bitree_data(left))->factor = AVL_LEFT_HEAVY;
+                bistree_avl(*node)->factor = AVL_BALANCED;
+                bistree_avl(left)->factor = AVL_LEFT_HEAVY;
                 break;
         }
 
-        ((AvlNode*) bitree_data((grandchild)))->factor = AVL_BALANCED;
+        bistree_avl(grandchild)->factor = AVL_BALANCED;
+
+        update(left);
+        update(*node);
+        update(grandchild);
         *node = grandchild;
     }
 }
@@ -55,14 +121,16 @@ static void rotate_right(BiTreeNode** node) {
 
     right = bitree_right(*node);
 
-    if (((AvlNode*) bitree_data(right))->factor == AVL_RIGHT_HEAVY) {
+    if (bistree_avl(right)->factor == AVL_RIGHT_HEAVY) {
         /* Perform an RR rotation */
         bitree_right(*node) = bitree_left(right);
         bitree_left(right) = *node;
 
-        ((AvlNode*) bitree_data(*node))->factor = AVL_BALANCED;
-        ((AvlNode*) bitree_data(right))->factor = AVL_BALANCED;
+        bistree_avl(*node)->factor = AVL_BALANCED;
+        bistree_avl(right)->factor = AVL_BALANCED;
 
+        update(*node);
+        update(right);
         *node = right;
     }
     else {
@@ -73,24 +141,28 @@ static void rotate_right(BiTreeNode** node) {
         bitree_right(*node) = bitree_left(grandchild);
         bitree_left(grandchild) = *node;
 
-        switch (((AvlNode*) bitree_data(grandchild))->factor) {
+        switch (bistree_avl(grandchild)->factor) {
             case AVL_LEFT_HEAVY:
-                ((AvlNode*) bitree_data(*node))->factor = AVL_BALANCED;
-                ((AvlNode*) bitree_data(right))->factor = AVL_RIGHT_HEAVY;
+                bistree_avl(*node)->factor = AVL_BALANCED;
+                bistree_avl(right)->factor = AVL_RIGHT_HEAVY;
                 break;
 
             case AVL_BALANCED:
-                ((AvlNode*) bitree_data(*node))->factor = AVL_BALANCED;
-                ((AvlNode*) bitree_data(right))->factor = AVL_BALANCED;
+                bistree_avl(*node)->factor = AVL_BALANCED;
+                bistree_avl(right)->factor = AVL_BALANCED;
                 break;
 
             case AVL_RIGHT_HEAVY:
-                ((AvlNode*) bitree_data(*node))->factor = AVL_LEFT_HEAVY;
-                ((AvlNode*) bitree_data(right))->factor = AVL_BALANCED;
+                bistree_avl(*node)->factor = AVL_LEFT_HEAVY;
+                bistree_avl(right)->factor = AVL_BALANCED;
                 break;
         }
 
-        ((AvlNode*) bitree_data(grandchild))->factor = AVL_BALANCED;
+        bistree_avl(grandchild)->factor = AVL_BALANCED;
+
+        update(right);
+        update(*node);
+        update(grandchild);
         *node = grandchild;
     }
 }
@@ -114,12 +186,10 @@ static void destroy_left(BisTree* tree, BiTreeNode* node) {
 
     if (tree->destroy) {
         /* Call a user-defined function to free dynamically allocated data */
-        tree->destroy(((AvlNode*) (*position)->data)->data);
+        tree->destroy(bistree_avl(*position)->data);
     }
 
-    /* Free the AVL data in the node, then free the node itself */
-    free((*position)->data);
-    free(*position);
+    /* The node itself goes back with its slab */
     *position = NULL;
 
     /* Adjust the size of the tree */
@@ -145,78 +215,67 @@ static void destroy_right(BisTree* tree, BiTreeNode* node) {
 
     if (tree->destroy) {
         /* Call a user-defined function to free dynamically allocated data */
-        tree->destroy(((AvlNode*) (*position)->data)->data);
+        tree->destroy(bistree_avl(*position)->data);
     }
 
-    /* Free the AVL data in the node, then free the node itself */
-    free((*position)->data);
-    free(*position);
+    /* The node itself goes back with its slab */
     *position = NULL;
 
     /* Adjust the size of the tree */
     tree->size -= 1;
 }
 
-static int insert(BisTree* tree, BiTreeNode** node, const void* data, int* balanced) {
-    AvlNode* avl_node;
-
+static int insert(BisTree* tree, BiTreeNode** node, const void* data, unsigned long long prefix, int* balanced) {
     int cmpval, retval;
 
     /* Insert data into the tree */
     if (bitree_is_eob(*node)) {
         /* Handle insertion into an empty tree */
-        avl_node = (AvlNode*) malloc(sizeof(AvlNode));
-        if (!avl_node) {
+        *node = alloc_node(tree, data);
+        if (!*node) {
             return -1;
         }
 
-        avl_node->factor = AVL_BALANCED;
-        avl_node->hidden = 0;
-        avl_node->data = (void*) data;
-
-        return bitree_ins_left(tree, *node, avl_node);
+        tree->size += 1;
+        return 0;
     }
     else {
         /* Handle insertion into a tree that's not empty */
-        cmpval = tree->compare(data, ((AvlNode*) bitree_data(*node))->data);
+        cmpval = order(tree, data, prefix, *node);
         if (cmpval < 0) {
             /* Move to the left */
             if (bitree_is_eob(bitree_left(*node))) {
-                avl_node = (AvlNode*) malloc(sizeof(AvlNode));
-                if (!avl_node) {
+                bitree_left(*node) = alloc_node(tree, data);
+                if (!bitree_left(*node)) {
                     return -1;
                 }
 
-                avl_node->factor = AVL_BALANCED;
-                avl_node->hidden = 0;
-                avl_node->data = (void*) data;
-
-                if (bitree_ins_left(tree, *node, avl_node)) {
-                    return -1;
-                }
+                tree->size += 1;
                 *balanced = 0;
             }
             else {
-                retval = insert(tree, &bitree_left(*node), data, balanced);
+                retval = insert(tree, &bitree_left(*node), data, prefix, balanced);
                 if (retval) {
                     return retval;
                 }
             }
 
+            update(*node);
+
             /* Ensure the tree remains balanced */
             if (!(*balanced)) {
-                switch (((AvlNode*) bitree_data(*node))->factor) {
+                switch (bistree_avl(*node)->factor) {
                     case AVL_LEFT_HEAVY:
                         rotate_left(node);
                         *balanced = 1;
                         break;
 
                     case AVL_BALANCED:
-                        ((AvlNode*) bitree_data(*node))->factor = AVL_LEFT_HEAVY;
+                        bistree_avl(*node)->factor = AVL_LEFT_HEAVY;
                         break;
 
                     case AVL_RIGHT_HEAVY:
-                        ((AvlNode*) bitree_data(*node))->factor = AVL_BALANCED;
+                        bistree_avl(*node)->factor = AVL_BALANCED;
                         *balanced = 1;
                         break;
                 }
@@ -225,37 +284,33 @@ static int insert(BisTree* tree, BiTreeNode** node, const void* data, int* balan
         else if (cmpval > 0) {
             /* Move to the right */
             if (bitree_is_eob(bitree_right(*node))) {
-                avl_node = (AvlNode*) malloc(sizeof(AvlNode));
-                if (!avl_node) {
+                bitree_right(*node) = alloc_node(tree, data);
+                if (!bitree_right(*node)) {
                     return -1;
                 }
 
-                avl_node->factor = AVL_BALANCED;
-                avl_node->hidden = 0;
-                avl_node->data = (void*) data;
-
-                if (bitree_ins_right(tree, *node, avl_node)) {
-                    return -1;
-                }
+                tree->size += 1;
                 *balanced = 0;
             }
             else {
-                retval = insert(tree, &bitree_right(*node), data, balanced);
+                retval = insert(tree, &bitree_right(*node), data, prefix, balanced);
                 if (retval) {
                     return retval;
                 }
             }
 
+            update(*node);
+
             /* Ensure the tree remains balanced */
             if (!(*balanced)) {
-                switch (((AvlNode*) bitree_data(*node))->factor) {
+                switch (bistree_avl(*node)->factor) {
                     case AVL_LEFT_HEAVY:
-                        ((AvlNode*) bitree_data(*node))->factor = AVL_BALANCED;
+                        bistree_avl(*node)->factor = AVL_BALANCED;
                         *balanced = 1;
                         break;
 
                     case AVL_BALANCED:
-                        ((AvlNode*) bitree_data(*node))->factor = AVL_RIGHT_HEAVY;
+                        bistree_avl(*node)->factor = AVL_RIGHT_HEAVY;
                         break;
 
                     case AVL_RIGHT_HEAVY:
@@ -267,7 +322,7 @@ static int insert(BisTree* tree, BiTreeNode** node, const void* data, int* balan
         } /* if (cmpval > 0) */
         else {
             /* Handle finding a copy of the data */
-            if (!((AvlNode*) bitree_data(*node))->hidden) {
+            if (!bistree_avl(*node)->hidden) {
                 /* Do nothing since the data is in the tree & not hidden */
                 return 1;
             }
@@ -275,11 +330,13 @@ static int insert(BisTree* tree, BiTreeNode** node, const void* data, int* balan
                 /* Insert the new data & mark it as not hidden */
                 if (tree->destroy) {
                     /* Destroy the hidden data since it's being replaced */
-                    tree->destroy(((AvlNode*) bitree_data(*node))->data);
+                    tree->destroy(bistree_avl(*node)->data);
                 }
 
-                ((AvlNode*) bitree_data(*node))->data = (void*) data;
-                ((AvlNode*) bitree_data(*node))->hidden = 0;
+                bistree_avl(*node)->data = (void*) data;
+                bistree_avl(*node)->hidden = 0;
+                tree->hidden -= 1;
+                update(*node);
 
                 /* Don't rebalance since the tree structure is unchanged */
                 *balanced = 1;
@@ -290,7 +347,7 @@ static int insert(BisTree* tree, BiTreeNode** node, const void* data, int* balan
     return 0;
 }
 
-static int hide(BisTree* tree, BiTreeNode* node, const void* data) {
+static int hide(BisTree* tree, BiTreeNode* node, const void* data, unsigned long long prefix) {
     int cmpval, retval;
 
     if (bitree_is_eob(node)) {
@@ -298,25 +355,307 @@ static int hide(BisTree* tree, BiTreeNode* node, const void* data) {
         return -1;
     }
 
-    cmpval = tree->compare(data, ((AvlNode*) bitree_data(node))->data);
+    cmpval = order(tree, data, prefix, node);
     if (cmpval < 0) {
         /* Move to the left */
-        retval = hide(tree, bitree_left(node), data);
+        retval = hide(tree, bitree_left(node), data, prefix);
     }
     else if (cmpval > 0) {
         /* Move to the right */
-        retval = hide(tree, bitree_right(node), data);
+        retval = hide(tree, bitree_right(node), data, prefix);
     }
-    else {
+    else if (!bistree_avl(node)->hidden) {
         /* Mark the node as hidden */
-        ((AvlNode*) bitree_data(node))->hidden = 1;
+        bistree_avl(node)->hidden = 1;
+        tree->hidden += 1;
+        retval = 0;
+    }
+    else {
+        /* Data already removed */
+        retval = -1;
+    }
+
+    if (!retval) {
+        update(node);
+    }
+
+    return retval;
+}
+
+static void free_node(BisTree* tree, BiTreeNode* node) {
+    /* Chain the node onto the free list through its right link */
+    bitree_right(node) = (BiTreeNode*) tree->free;
+    tree->free = bistree_avl(node);
+}
+
+static void shrink_left(BiTreeNode** node, int* shorter) {
+    BiTreeNode* right;
+
+    /* The left subtree has just become one level shorter */
+    switch (bistree_avl(*node)->factor) {
+        case AVL_LEFT_HEAVY:
+            bistree_avl(*node)->factor = AVL_BALANCED;
+            break;
+
+        case AVL_BALANCED:
+            bistree_avl(*node)->factor = AVL_RIGHT_HEAVY;
+            *shorter = 0;
+            break;
+
+        case AVL_RIGHT_HEAVY:
+            right = bitree_right(*node);
+
+            if (bistree_avl(right)->factor == AVL_BALANCED) {
+                /* Perform an RR rotation that leaves the height unchanged */
+                bitree_right(*node) = bitree_left(right);
+                bitree_left(right) = *node;
+
+                bistree_avl(*node)->factor = AVL_RIGHT_HEAVY;
+                bistree_avl(right)->factor = AVL_LEFT_HEAVY;
+
+                update(*node);
+                update(right);
+                *node = right;
+                *shorter = 0;
+            }
+            else {
+                rotate_right(node);
+            }
+            break;
+    }
+}
+
+static void shrink_right(BiTreeNode** node, int* shorter) {
+    BiTreeNode* left;
+
+    /* The right subtree has just become one level shorter */
+    switch (bistree_avl(*node)->factor) {
+        case AVL_RIGHT_HEAVY:
+            bistree_avl(*node)->factor = AVL_BALANCED;
+            break;
+
+        case AVL_BALANCED:
+            bistree_avl(*node)->factor = AVL_LEFT_HEAVY;
+            *shorter = 0;
+            break;
+
+        case AVL_LEFT_HEAVY:
+            left = bitree_left(*node);
+
+            if (bistree_avl(left)->factor == AVL_BALANCED) {
+                /* Perform an LL rotation that leaves the height unchanged */
+                bitree_left(*node) = bitree_right(left);
+                bitree_right(left) = *node;
+
+                bistree_avl(*node)->factor = AVL_LEFT_HEAVY;
+                bistree_avl(left)->factor = AVL_RIGHT_HEAVY;
+
+                update(*node);
+                update(left);
+                *node = left;
+                *shorter = 0;
+            }
+            else {
+                rotate_left(node);
+            }
+            break;
+    }
+}
+
+static void detach_min(BiTreeNode** node, BiTreeNode** min, int* shorter) {
+    if (bitree_is_eob(bitree_left(*node))) {
+        /* Splice out the leftmost node */
+        *min = *node;
+        *node = bitree_right(*node);
+        *shorter = 1;
+        return;
+    }
+
+    detach_min(&bitree_left(*node), min, shorter);
+    update(*node);
+
+    if (*shorter) {
+        shrink_left(node, shorter);
+    }
+}
+
+static int delete(BisTree* tree, BiTreeNode** node, void** data, unsigned long long prefix, int* shorter) {
+    BiTreeNode* target;
+    BiTreeNode* min;
+    int cmpval, retval;
+
+    if (bitree_is_eob(*node)) {
+        /* Data not found */
+        return -1;
+    }
+
+    cmpval = order(tree, *data, prefix, *node);
+    if (cmpval < 0) {
+        /* Move to the left */
+        retval = delete(tree, &bitree_left(*node), data, prefix, shorter);
+        update(*node);
+
+        if (*shorter) {
+            shrink_left(node, shorter);
+        }
+
+        return retval;
+    }
+    else if (cmpval > 0) {
+        /* Move to the right */
+        retval = delete(tree, &bitree_right(*node), data, prefix, shorter);
+        update(*node);
+
+        if (*shorter) {
+            shrink_right(node, shorter);
+        }
+
+        return retval;
+    }
+
+    target = *node;
+
+    if (bistree_avl(target)->hidden) {
+        /* Drop the hidden node too, but its data is no longer in the tree */
+        if (tree->destroy) {
+            tree->destroy(bistree_avl(target)->data);
+        }
+
+        tree->hidden -= 1;
+        retval = -1;
+    }
+    else {
+        /* Pass the data back from the tree */
+        *data = bistree_avl(target)->data;
         retval = 0;
     }
 
+    if (bitree_is_eob(bitree_left(target))) {
+        *node = bitree_right(target);
+        *shorter = 1;
+    }
+    else if (bitree_is_eob(bitree_right(target))) {
+        *node = bitree_left(target);
+        *shorter = 1;
+    }
+    else {
+        /* Replace the node with the smallest node to its right */
+        detach_min(&bitree_right(target), &min, shorter);
+
+        bitree_left(min) = bitree_left(target);
+        bitree_right(min) = bitree_right(target);
+        bistree_avl(min)->factor = bistree_avl(target)->factor;
+        update(min);
+        *node = min;
+
+        if (*shorter) {
+            shrink_right(node, shorter);
+        }
+    }
+
+    free_node(tree, target);
+    tree->size -= 1;
+
     return retval;
 }
 
-static int lookup(BisTree* tree, BiTreeNode* node, void** data) {
+static void flatten(const BiTreeNode* node, void** items, int* count) {
+    if (bitree_is_eob(node)) {
+        return;
+    }
+
+    flatten(bitree_left(node), items, count);
+
+    if (!bistree_avl(node)->hidden) {
+        items[(*count)++] = bistree_avl(node)->data;
+    }
+
+    flatten(bitree_right(node), items, count);
+}
+
+static void destroy_hidden(BisTree* tree, const BiTreeNode* node) {
+    if (bitree_is_eob(node)) {
+        return;
+    }
+
+    destroy_hidden(tree, bitree_left(node));
+    destroy_hidden(tree, bitree_right(node));
+
+    if (bistree_avl(node)->hidden) {
+        tree->destroy(bistree_avl(node)->data);
+    }
+}
+
+static BiTreeNode* link(void** nodes, int count, int* height) {
+    BiTreeNode* node;
+    int left, right, middle;
+
+    if (!count) {
+        *height = 0;
+        return NULL;
+    }
+
+    /* The middle node is the root, with any odd node out going to the right */
+    middle = (count - 1) / 2;
+    node = nodes[middle];
+    bitree_left(node) = link(nodes, middle, &left);
+    bitree_right(node) = link(nodes + middle + 1, count - middle - 1, &right);
+    bistree_avl(node)->factor = left == right ? AVL_BALANCED : AVL_RIGHT_HEAVY;
+    update(node);
+
+    *height = (left > right ? left : right) + 1;
+    return node;
+}
+
+static void free_slabs(AvlSlab* slab) {
+    AvlSlab* next;
+
+    while (slab) {
+        next = slab->next;
+        free(slab);
+        slab = next;
+    }
+}
+
+static int build(BisTree* tree, void** items, int count) {
+    BisTree fresh;
+    int height, i;
+
+    bistree_init(&fresh, tree->compare, tree->destroy);
+    fresh.prefix = tree->prefix;
+
+    /* Lay the nodes out in sorted order, then swap each item for its node */
+    for (i = 0; i < count; i++) {
+        items[i] = alloc_node(&fresh, items[i]);
+        if (!items[i]) {
+            /* Put back the items already swapped out */
+            while (--i >= 0) {
+                items[i] = bistree_avl(items[i])->data;
+            }
+
+            free_slabs(fresh.slabs);
+            return -1;
+        }
+    }
+
+    /* Hidden data goes only once the new tree is safely built */
+    if (tree->hidden && tree->destroy) {
+        destroy_hidden(tree, bitree_root(tree));
+    }
+
+    free_slabs(tree->slabs);
+
+    tree->root = link(items, count, &height);
+    tree->size = count;
+    tree->slabs = fresh.slabs;
+    tree->used = fresh.used;
+    tree->free = NULL;
+    tree->hidden = 0;
+
+    return 0;
+}
+
+static int lookup(BisTree* tree, BiTreeNode* node, void** data, unsigned long long prefix) {
     int cmpval, retval;
 
     if (bitree_is_eob(node)) {
@@ -324,18 +663,18 @@ static int lookup(BisTree* tree, BiTreeNode* node, void** data) {
         return -1;
     }
 
-    cmpval = tree->compare(*data, ((AvlNode*) bitree_data(node))->data);
+    cmpval = order(tree, *data, prefix, node);
     if (cmpval < 0) {
         /* Move to the left */
-        retval = lookup(tree, bitree_left(node), data);
+        retval = lookup(tree, bitree_left(node), data, prefix);
     }
     else if (cmpval > 0) {
         /* Move to the right */
-        retval = lookup(tree, bitree_right(node), data);
+        retval = lookup(tree, bitree_right(node), data, prefix);
     }
-    else if (!((AvlNode*) bitree_data(node))->hidden) {
+    else if (!bistree_avl(node)->hidden) {
             /* Pass the data back from the tree */
-        *data = ((AvlNode*) bitree_data(node))->data;
+        *data = bistree_avl(node)->data;
         retval = 0;
     }
     else {
@@ -349,25 +688,1000 @@ static int lookup(BisTree* tree, BiTreeNode* node, void** data) {
 void bistree_init(BisTree* tree,
                   int (*compare)(const void* key1, const void* key2),
                   void (*destroy)(void* data)) {
-    bitree_init(tree, destroy);
+    bitree_init((BiTree*) tree, destroy);
     tree->compare = compare;
+    tree->slabs = NULL;
+    tree->used = 0;
+    tree->free = NULL;
+    tree->hidden = 0;
+    tree->threshold = AVL_THRESHOLD;
+    tree->prefix = NULL;
 }
 
 void bistree_destroy(BisTree* tree) {
     destroy_left(tree, NULL);
+
+    /* Free the nodes a slab at a time */
+    free_slabs(tree->slabs);
+
     memset(tree, 0, sizeof(BisTree));
 }
 
 int bistree_insert(BisTree* tree, const void* data) {
     int balanced = 0;
-    return insert(tree, &bitree_root(tree), data, &balanced);
+    return insert(tree, &bitree_root(tree), data, key_prefix(tree, data), &balanced);
 }
 
 int bistree_remove(BisTree* tree, const void* data) {
-    return hide(tree, bitree_root(tree), data);
+    if (hide(tree, bitree_root(tree), data, key_prefix(tree, data))) {
+        return -1;
+    }
+
+    /* Compact once too much of the tree is hidden */
+    if (tree->threshold > 0.0 && tree->hidden > tree->threshold * bistree_size(tree)) {
+        bistree_rebuild(tree);
+    }
+
+    return 0;
 }
 
 int bistree_lookup(BisTree* tree, void** data) {
-    return lookup(tree, bitree_root(tree), data);
+    return lookup(tree, bitree_root(tree), data, key_prefix(tree, *data));
+}
+
+int bistree_lookup_batch(const BisTree* tree, void* const* keys, int count, void** results) {
+    const BiTreeNode* nodes[AVL_BATCH];
+    unsigned long long prefixes[AVL_BATCH];
+    int slots[AVL_BATCH];
+    const BiTreeNode* node;
+    int next, active, found, cmpval, i;
+
+    found = 0;
+    next = 0;
+    active = 0;
+
+    /* Keep a window of searches going, each taking one step per pass */
+    while (next < count || active) {
+        while (active < AVL_BATCH && next < count) {
+            results[next] = NULL;
+            nodes[active] = bitree_root(tree);
+            prefixes[active] = key_prefix(tree, keys[next]);
+            slots[active++] = next++;
+        }
+
+        for (i = 0; i < active; i++) {
+            node = nodes[i];
+            cmpval = bitree_is_eob(node) ? 0 : order(tree, keys[slots[i]], prefixes[i], node);
+
+            if (cmpval) {
+                /* Move down & start fetching the child while the other searches run */
+                node = cmpval < 0 ? bitree_left(node) : bitree_right(node);
+                __builtin_prefetch(node);
+                nodes[i] = node;
+                continue;
+            }
+
+            if (!bitree_is_eob(node) && !bistree_avl(node)->hidden) {
+                /* Pass the data back from the tree */
+                results[slots[i]] = bistree_avl(node)->data;
+                found++;
+            }
+
+            /* Fill the finished search's place with the last one in the window */
+            active--;
+            nodes[i] = nodes[active];
+            prefixes[i] = prefixes[active];
+            slots[i] = slots[active];
+            i--;
+        }
+    }
+
+    return found;
+}
+
+
+int bistree_delete(BisTree* tree, void** data) {
+    int shorter = 0;
+    return delete(tree, &bitree_root(tree), data, key_prefix(tree, *data), &shorter);
+}
+
+int bistree_rebuild(BisTree* tree) {
+    void** items;
+    int count, retval;
+
+    items = malloc((bistree_size(tree) - tree->hidden + 1) * sizeof(void*));
+    if (!items) {
+        return -1;
+    }
+
+    /* Gather the live data in order, then rebuild around it */
+    count = 0;
+    flatten(bitree_root(tree), items, &count);
+    retval = build(tree, items, count);
+
+    free(items);
+    return retval;
 }
 
+void bistree_set_threshold(BisTree* tree, double threshold) {
+    tree->threshold = threshold;
+}
+
+static void fill_prefixes(const BisTree* tree, BiTreeNode* node) {
+    if (bitree_is_eob(node)) {
+        return;
+    }
+
+    bistree_avl(node)->prefix = key_prefix(tree, bistree_avl(node)->data);
+    fill_prefixes(tree, bitree_left(node));
+    fill_prefixes(tree, bitree_right(node));
+}
+
+void bistree_set_prefix(BisTree* tree, unsigned long long (*prefix)(const void* data)) {
+    /* Wherever two prefixes differ they must order the keys as compare does */
+    /* Nodes already in the tree take their prefixes from the new extractor */
+    tree->prefix = prefix;
+    fill_prefixes(tree, bitree_root(tree));
+}
+
+unsigned long long bistree_string_prefix(const char* key) {
+    unsigned long long prefix;
+    int i;
+
+    /* Pack the first bytes most significant first, so prefixes order like strcmp */
+    prefix = 0;
+    for (i = 0; i < 8; i++) {
+        prefix <<= 8;
+        if (*key) {
+            prefix |= (unsigned char) *key++;
+        }
+    }
+
+    return prefix;
+}
+
+void bistree_stats(const BisTree* tree, BisTreeStats* stats) {
+    const BiTreeNode* node;
+
+    stats->live = bistree_size(tree) - tree->hidden;
+    stats->hidden = tree->hidden;
+    stats->height = 0;
+
+    /* Follow the taller side down, which the balance factors point out */
+    for (node = bitree_root(tree); !bitree_is_eob(node); stats->height++) {
+        node = bistree_avl(node)->factor == AVL_LEFT_HEAVY ? bitree_left(node) : bitree_right(node);
+    }
+}
+
+static int is_sorted(const BisTree* tree, void* const* items, int count) {
+    int i;
+
+    for (i = 1; i < count; i++) {
+        if (tree->compare(items[i - 1], items[i]) >= 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int bistree_build_sorted(BisTree* tree, void* const* items, int count) {
+    void** nodes;
+    int retval;
+
+    /* Allow loading only into an empty tree, from strictly ascending items */
+    if (bistree_size(tree) || count < 0 || !is_sorted(tree, items, count)) {
+        return -1;
+    }
+
+    nodes = malloc((count + 1) * sizeof(void*));
+    if (!nodes) {
+        return -1;
+    }
+
+    memcpy(nodes, items, count * sizeof(void*));
+    retval = build(tree, nodes, count);
+
+    free(nodes);
+    return retval;
+}
+
+int bistree_merge_sorted(BisTree* tree, void* const* items, int count) {
+    BisTreeStats stats;
+    void** merged;
+    int live, added, cmpval, i, j, k;
+
+    if (count < 0 || !is_sorted(tree, items, count)) {
+        return -1;
+    }
+
+    bistree_stats(tree, &stats);
+
+    /* A small batch is cheaper to insert one item at a time */
+    if ((long) count * stats.height < (long) bistree_size(tree) + count) {
+        added = 0;
+
+        for (i = 0; i < count; i++) {
+            switch (bistree_insert(tree, items[i])) {
+                case 0:
+                    added += 1;
+                    break;
+
+                case 1:
+                    break;
+
+                default:
+                    return -1;
+            }
+        }
+
+        return added;
+    }
+
+    /* Otherwise merge the batch with the live data & rebuild */
+    merged = malloc(((long) stats.live + count + 1) * sizeof(void*));
+    if (!merged) {
+        return -1;
+    }
+
+    live = 0;
+    flatten(bitree_root(tree), merged + count, &live);
+
+    i = count;
+    j = k = 0;
+    while (i < count + live || j < count) {
+        if (j == count) {
+            merged[k++] = merged[i++];
+            continue;
+        }
+
+        cmpval = i < count + live ? tree->compare(merged[i], items[j]) : 1;
+        if (cmpval < 0) {
+            merged[k++] = merged[i++];
+        }
+        else if (cmpval > 0) {
+            merged[k++] = items[j++];
+        }
+        else {
+            /* Keep the data already in the tree, as bistree_insert does */
+            merged[k++] = merged[i++];
+            j += 1;
+        }
+    }
+
+    added = k - live;
+    if (build(tree, merged, k)) {
+        added = -1;
+    }
+
+    free(merged);
+    return added;
+}
+
+static void lay_out(void** sorted, int* next, void** data, int k, int size) {
+    /* An in-order walk of the implicit tree visits its slots in sorted order */
+    if (k > size) {
+        return;
+    }
+
+    lay_out(sorted, next, data, 2 * k, size);
+    data[k] = sorted[(*next)++];
+    lay_out(sorted, next, data, 2 * k + 1, size);
+}
+
+int bistree_freeze(const BisTree* tree, BisFrozen* frozen) {
+    void** sorted;
+    int count, next;
+
+    count = bistree_size(tree) - tree->hidden;
+    sorted = malloc((count + 1) * sizeof(void*));
+    frozen->data = malloc((count + 1) * sizeof(void*));
+
+    if (!sorted || !frozen->data) {
+        free(sorted);
+        free(frozen->data);
+        frozen->data = NULL;
+        return -1;
+    }
+
+    count = 0;
+    flatten(bitree_root(tree), sorted, &count);
+
+    next = 0;
+    frozen->data[0] = NULL;
+    lay_out(sorted, &next, frozen->data, 1, count);
+
+    frozen->size = count;
+    frozen->compare = tree->compare;
+
+    free(sorted);
+    return 0;
+}
+
+void bistree_frozen_destroy(BisFrozen* frozen) {
+    /* The data still belongs to the tree */
+    free(frozen->data);
+    memset(frozen, 0, sizeof(BisFrozen));
+}
+
+int bistree_frozen_lookup(const BisFrozen* frozen, void** data) {
+    unsigned long k;
+
+    /* Descend without branching on the result, fetching four levels ahead */
+    k = 1;
+    while (k <= (unsigned long) frozen->size) {
+        __builtin_prefetch(frozen->data + 16 * k);
+        __builtin_prefetch(frozen->data + 16 * k + 8);
+        k = 2 * k + (frozen->compare(frozen->data[k], *data) < 0);
+    }
+
+    /* Undo the right turns taken after the last left turn to find the lower bound */
+    k >>= __builtin_ctzl(~k) + 1;
+    if (!k || frozen->compare(frozen->data[k], *data) != 0) {
+        /* Data not found */
+        return -1;
+    }
+
+    /* Pass the data back from the snapshot */
+    *data = frozen->data[k];
+    return 0;
+}
+
+static int step(BisCursor* cursor, int forward) {
+    const BiTreeNode* node;
+    const BiTreeNode* child;
+
+    if (!cursor->depth) {
+        return -1;
+    }
+
+    node = cursor->path[cursor->depth - 1];
+    child = forward ? bitree_right(node) : bitree_left(node);
+
+    if (!bitree_is_eob(child)) {
+        /* Go down one step the chosen way, then as far as possible the other */
+        while (!bitree_is_eob(child)) {
+            cursor->path[cursor->depth++] = child;
+            child = forward ? bitree_left(child) : bitree_right(child);
+        }
+    }
+    else {
+        /* Climb until arriving from the side opposite the step */
+        do {
+            child = cursor->path[--cursor->depth];
+        } while (cursor->depth
+                 && child == (forward ? bitree_right(cursor->path[cursor->depth - 1])
+                                      : bitree_left(cursor->path[cursor->depth - 1])));
+    }
+
+    return cursor->depth ? 0 : -1;
+}
+
+static int step_live(BisCursor* cursor, int forward) {
+    /* Pass over hidden nodes */
+    do {
+        if (step(cursor, forward)) {
+            return -1;
+        }
+    } while (bistree_avl(cursor->path[cursor->depth - 1])->hidden);
+
+    return 0;
+}
+
+static int seek(const BisTree* tree, BisCursor* cursor, const void* data, int forward) {
+    const BiTreeNode* node;
+    unsigned long long prefix;
+    int found, cmpval;
+
+    /* Remember the depth of the closest node on the wanted side of the data */
+    cursor->depth = 0;
+    found = 0;
+    prefix = data ? key_prefix(tree, data) : 0;
+
+    for (node = bitree_root(tree); !bitree_is_eob(node); ) {
+        cursor->path[cursor->depth++] = node;
+        cmpval = data ? order(tree, data, prefix, node) : (forward ? -1 : 1);
+
+        if (forward ? cmpval <= 0 : cmpval >= 0) {
+            found = cursor->depth;
+        }
+
+        if (cmpval == 0) {
+            break;
+        }
+
+        node = cmpval < 0 ? bitree_left(node) : bitree_right(node);
+    }
+
+    cursor->depth = found;
+    if (!found) {
+        return -1;
+    }
+
+    if (bistree_avl(cursor->path[found - 1])->hidden) {
+        return step_live(cursor, forward);
+    }
+
+    return 0;
+}
+
+int bistree_seek(const BisTree* tree, BisCursor* cursor, const void* data) {
+    return seek(tree, cursor, data, 1);
+}
+
+int bistree_seek_last(const BisTree* tree, BisCursor* cursor, const void* data) {
+    return seek(tree, cursor, data, 0);
+}
+
+int bistree_next(BisCursor* cursor) {
+    return step_live(cursor, 1);
+}
+
+int bistree_prev(BisCursor* cursor) {
+    return step_live(cursor, 0);
+}
+
+int bistree_range(const BisTree* tree, const void* low, const void* high,
+                  int (*callback)(const void* data, void* arg), void* arg) {
+    BisCursor cursor;
+    int retval;
+
+    /* Walk forwards from the low bound until passing the high one */
+    for (retval = bistree_seek(tree, &cursor, low); !retval; retval = bistree_next(&cursor)) {
+        if (high && tree->compare(bistree_cursor_data(&cursor), high) > 0) {
+            break;
+        }
+
+        if (callback(bistree_cursor_data(&cursor), arg)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int bistree_rank(const BisTree* tree, const void* data) {
+    const BiTreeNode* node;
+    unsigned long long prefix;
+    int rank, cmpval;
+
+    /* Count the live nodes passed over on the left on the way down */
+    rank = 0;
+    prefix = key_prefix(tree, data);
+    node = bitree_root(tree);
+    while (!bitree_is_eob(node)) {
+        cmpval = order(tree, data, prefix, node);
+
+        if (cmpval <= 0) {
+            node = bitree_left(node);
+        }
+        else {
+            rank += count_live(bitree_left(node)) + !bistree_avl(node)->hidden;
+            node = bitree_right(node);
+        }
+    }
+
+    return rank;
+}
+
+int bistree_select(const BisTree* tree, int rank, void** data) {
+    const BiTreeNode* node;
+    int left;
+
+    if (rank < 0 || rank >= count_live(bitree_root(tree))) {
+        return -1;
+    }
+
+    node = bitree_root(tree);
+    for (;;) {
+        left = count_live(bitree_left(node));
+
+        if (rank < left) {
+            node = bitree_left(node);
+        }
+        else if (rank == left && !bistree_avl(node)->hidden) {
+            /* Pass the data back from the tree */
+            *data = bistree_avl(node)->data;
+            return 0;
+        }
+        else {
+            rank -= left + !bistree_avl(node)->hidden;
+            node = bitree_right(node);
+        }
+    }
+}
+
+/* Nodes dropped by a set operation, chained through their right links */
+typedef struct {
+    AvlNode* head;
+    AvlNode* tail;
+    int count;
+} AvlGarbage;
+
+/* One set operation on a pair of subtrees, possibly run on its own thread */
+typedef struct {
+    const BisTree* tree;
+    void (*destroy)(void* data);
+    int op;
+    int nthreads;
+    BiTreeNode* node1;
+    int height1;
+    BiTreeNode* node2;
+    int height2;
+    BiTreeNode* root;
+    int height;
+    AvlGarbage garbage;
+} AvlSetTask;
+
+enum { AVL_UNION, AVL_INTERSECT, AVL_DIFFERENCE };
+
+static int subtree_height(const BiTreeNode* node) {
+    int height;
+
+    /* Follow the taller side down, which the balance factors point out */
+    for (height = 0; !bitree_is_eob(node); height++) {
+        node = bistree_avl(node)->factor == AVL_RIGHT_HEAVY ? bitree_right(node) : bitree_left(node);
+    }
+
+    return height;
+}
+
+static int left_height(const BiTreeNode* node, int height) {
+    return height - 1 - (bistree_avl(node)->factor == AVL_RIGHT_HEAVY);
+}
+
+static int right_height(const BiTreeNode* node, int height) {
+    return height - 1 - (bistree_avl(node)->factor == AVL_LEFT_HEAVY);
+}
+
+static int make(BiTreeNode* node, BiTreeNode* left, int lheight, BiTreeNode* right, int rheight) {
+    /* The two sides must already differ in height by at most one */
+    bitree_left(node) = left;
+    bitree_right(node) = right;
+    bistree_avl(node)->factor = lheight - rheight;
+    update(node);
+
+    return (lheight > rheight ? lheight : rheight) + 1;
+}
+
+static int join_right(BiTreeNode* left, int lheight, BiTreeNode* middle, BiTreeNode* right, int rheight,
+                      BiTreeNode** joined) {
+    BiTreeNode* outer;
+    BiTreeNode* inner;
+    BiTreeNode* sub;
+    int houter, hinner, hsub, height;
+
+    /* Walk down the right spine of the taller left side to a subtree the right side can sit beside */
+    outer = bitree_left(left);
+    houter = left_height(left, lheight);
+    inner = bitree_right(left);
+    hinner = right_height(left, lheight);
+
+    if (hinner <= rheight + 1) {
+        hsub = make(middle, inner, hinner, right, rheight);
+        if (hsub <= houter + 1) {
+            *joined = left;
+            return make(left, outer, houter, middle, hsub);
+        }
+
+        /* Perform an RL rotation around the inner subtree */
+        height = make(left, outer, houter, bitree_left(inner), left_height(inner, hinner));
+        hsub = make(middle, bitree_right(inner), right_height(inner, hinner), right, rheight);
+        *joined = inner;
+        return make(inner, left, height, middle, hsub);
+    }
+
+    hsub = join_right(inner, hinner, middle, right, rheight, &sub);
+    if (hsub <= houter + 1) {
+        *joined = left;
+        return make(left, outer, houter, sub, hsub);
+    }
+
+    /* Perform an RR rotation */
+    height = make(left, outer, houter, bitree_left(sub), left_height(sub, hsub));
+    *joined = sub;
+    return make(sub, left, height, bitree_right(sub), right_height(sub, hsub));
+}
+
+static int join_left(BiTreeNode* left, int lheight, BiTreeNode* middle, BiTreeNode* right, int rheight,
+                     BiTreeNode** joined) {
+    BiTreeNode* outer;
+    BiTreeNode* inner;
+    BiTreeNode* sub;
+    int houter, hinner, hsub, height;
+
+    /* Walk down the left spine of the taller right side to a subtree the left side can sit beside */
+    outer = bitree_right(right);
+    houter = right_height(right, rheight);
+    inner = bitree_left(right);
+    hinner = left_height(right, rheight);
+
+    if (hinner <= lheight + 1) {
+        hsub = make(middle, left, lheight, inner, hinner);
+        if (hsub <= houter + 1) {
+            *joined = right;
+            return make(right, middle, hsub, outer, houter);
+        }
+
+        /* Perform an LR rotation around the inner subtree */
+        height = make(right, bitree_right(inner), right_height(inner, hinner), outer, houter);
+        hsub = make(middle, left, lheight, bitree_left(inner), left_height(inner, hinner));
+        *joined = inner;
+        return make(inner, middle, hsub, right, height);
+    }
+
+    hsub = join_left(left, lheight, middle, inner, hinner, &sub);
+    if (hsub <= houter + 1) {
+        *joined = right;
+        return make(right, sub, hsub, outer, houter);
+    }
+
+    /* Perform an LL rotation */
+    height = make(right, bitree_right(sub), right_height(sub, hsub), outer, houter);
+    *joined = sub;
+    return make(sub, bitree_left(sub), left_height(sub, hsub), right, height);
+}
+
+static int join(BiTreeNode* left, int lheight, BiTreeNode* middle, BiTreeNode* right, int rheight,
+                BiTreeNode** joined) {
+    /* Everything in left orders before middle & everything in right after it */
+    if (lheight > rheight + 1) {
+        return join_right(left, lheight, middle, right, rheight, joined);
+    }
+
+    if (rheight > lheight + 1) {
+        return join_left(left, lheight, middle, right, rheight, joined);
+    }
+
+    *joined = middle;
+    return make(middle, left, lheight, right, rheight);
+}
+
+static BiTreeNode* split(const BisTree* tree, BiTreeNode* node, int height, const AvlNode* key,
+                         BiTreeNode** left, int* lheight, BiTreeNode** right, int* rheight) {
+    BiTreeNode* middle;
+    int cmpval;
+
+    if (bitree_is_eob(node)) {
+        *left = NULL;
+        *lheight = 0;
+        *right = NULL;
+        *rheight = 0;
+        return NULL;
+    }
+
+    cmpval = order(tree, key->data, key->prefix, node);
+    if (cmpval == 0) {
+        /* Hand back the node matching the key along with the two sides */
+        *left = bitree_left(node);
+        *lheight = left_height(node, height);
+        *right = bitree_right(node);
+        *rheight = right_height(node, height);
+        return node;
+    }
+
+    if (cmpval < 0) {
+        middle = split(tree, bitree_left(node), left_height(node, height), key, left, lheight, right, rheight);
+        *rheight = join(*right, *rheight, node, bitree_right(node), right_height(node, height), right);
+    }
+    else {
+        middle = split(tree, bitree_right(node), right_height(node, height), key, left, lheight, right, rheight);
+        *lheight = join(bitree_left(node), left_height(node, height), node, *left, *lheight, left);
+    }
+
+    return middle;
+}
+
+static BiTreeNode* split_last(BiTreeNode* node, int height, BiTreeNode** rest, int* rheight) {
+    BiTreeNode* last;
+    BiTreeNode* sub;
+    int hsub;
+
+    if (bitree_is_eob(bitree_right(node))) {
+        *rest = bitree_left(node);
+        *rheight = left_height(node, height);
+        return node;
+    }
+
+    last = split_last(bitree_right(node), right_height(node, height), &sub, &hsub);
+    *rheight = join(bitree_left(node), left_height(node, height), node, sub, hsub, rest);
+    return last;
+}
+
+static int join_pair(BiTreeNode* left, int lheight, BiTreeNode* right, int rheight, BiTreeNode** joined) {
+    BiTreeNode* last;
+    BiTreeNode* rest;
+    int hrest;
+
+    if (bitree_is_eob(left)) {
+        *joined = right;
+        return rheight;
+    }
+
+    /* Join around the last node on the left */
+    last = split_last(left, lheight, &rest, &hrest);
+    return join(rest, hrest, last, right, rheight, joined);
+}
+
+static void discard(AvlGarbage* garbage, BiTreeNode* node, void (*destroy)(void* data)) {
+    if (destroy) {
+        /* Call a user-defined function to free dynamically allocated data */
+        destroy(bistree_avl(node)->data);
+    }
+
+    bitree_left(node) = NULL;
+    bitree_right(node) = (BiTreeNode*) garbage->head;
+    if (!garbage->head) {
+        garbage->tail = bistree_avl(node);
+    }
+
+    garbage->head = bistree_avl(node);
+    garbage->count += 1;
+}
+
+static void discard_all(AvlGarbage* garbage, BiTreeNode* node, void (*destroy)(void* data)) {
+    if (bitree_is_eob(node)) {
+        return;
+    }
+
+    discard_all(garbage, bitree_left(node), destroy);
+    discard_all(garbage, bitree_right(node), destroy);
+    discard(garbage, node, destroy);
+}
+
+static void gather(AvlGarbage* garbage, const AvlGarbage* more) {
+    if (!more->head) {
+        return;
+    }
+
+    if (garbage->head) {
+        bitree_right(&garbage->tail->node) = (BiTreeNode*) more->head;
+    }
+    else {
+        garbage->head = more->head;
+    }
+
+    garbage->tail = more->tail;
+    garbage->count += more->count;
+}
+
+static void set_op(AvlSetTask* task);
+
+static void* run_set_op(void* arg) {
+    set_op(arg);
+    return NULL;
+}
+
+static void set_op(AvlSetTask* task) {
+    AvlSetTask halves[2];
+    pthread_t thread;
+    BiTreeNode* pivot;
+    BiTreeNode* match;
+    BiTreeNode* keep;
+    BiTreeNode* left;
+    BiTreeNode* right;
+    int lheight, rheight, forked, i;
+
+    task->garbage.head = NULL;
+    task->garbage.tail = NULL;
+    task->garbage.count = 0;
+
+    if (bitree_is_eob(task->node1) || bitree_is_eob(task->node2)) {
+        /* Whatever is left of the second tree survives only a union */
+        task->root = task->node1;
+        task->height = task->height1;
+
+        if (task->op == AVL_UNION && bitree_is_eob(task->node1)) {
+            task->root = task->node2;
+            task->height = task->height2;
+        }
+        else {
+            discard_all(&task->garbage, task->node2, task->destroy);
+        }
+
+        if (task->op == AVL_INTERSECT) {
+            discard_all(&task->garbage, task->node1, task->destroy);
+            task->root = NULL;
+            task->height = 0;
+        }
+
+        return;
+    }
+
+    for (i = 0; i < 2; i++) {
+        halves[i] = *task;
+    }
+
+    /* Split one side around the root of the other, pairing up what falls on each side */
+    if (task->op != AVL_DIFFERENCE) {
+        pivot = task->node1;
+        match = split(task->tree, task->node2, task->height2, bistree_avl(pivot), &left, &lheight, &right, &rheight);
+
+        halves[0].node1 = bitree_left(pivot);
+        halves[0].height1 = left_height(pivot, task->height1);
+        halves[0].node2 = left;
+        halves[0].height2 = lheight;
+        halves[1].node1 = bitree_right(pivot);
+        halves[1].height1 = right_height(pivot, task->height1);
+        halves[1].node2 = right;
+        halves[1].height2 = rheight;
+    }
+    else {
+        pivot = task->node2;
+        match = split(task->tree, task->node1, task->height1, bistree_avl(pivot), &left, &lheight, &right, &rheight);
+
+        halves[0].node1 = left;
+        halves[0].height1 = lheight;
+        halves[0].node2 = bitree_left(pivot);
+        halves[0].height2 = left_height(pivot, task->height2);
+        halves[1].node1 = right;
+        halves[1].height1 = rheight;
+        halves[1].node2 = bitree_right(pivot);
+        halves[1].height2 = right_height(pivot, task->height2);
+    }
+
+    /* Hand one half to another thread while both halves are big enough to pay for it */
+    forked = 0;
+    if (task->nthreads > 1 && count_live(task->node1) + count_live(task->node2) >= AVL_SET_GRAIN) {
+        halves[0].nthreads = task->nthreads / 2;
+        halves[1].nthreads = task->nthreads - task->nthreads / 2;
+        forked = !pthread_create(&thread, NULL, run_set_op, &halves[0]);
+    }
+
+    if (!forked) {
+        set_op(&halves[0]);
+    }
+
+    set_op(&halves[1]);
+
+    if (forked) {
+        pthread_join(thread, NULL);
+    }
+
+    /* Decide which of the two middle nodes, if any, goes between the halves */
+    switch (task->op) {
+        case AVL_UNION:
+            keep = pivot;
+            if (match && bistree_avl(pivot)->hidden && !bistree_avl(match)->hidden) {
+                keep = match;
+                discard(&task->garbage, pivot, task->destroy);
+            }
+            else if (match) {
+                discard(&task->garbage, match, task->destroy);
+            }
+            break;
+
+        case AVL_INTERSECT:
+            keep = NULL;
+            if (match && !bistree_avl(pivot)->hidden && !bistree_avl(match)->hidden) {
+                keep = pivot;
+            }
+            else {
+                discard(&task->garbage, pivot, task->destroy);
+            }
+
+            if (match) {
+                discard(&task->garbage, match, task->destroy);
+            }
+            break;
+
+        default:
+            keep = NULL;
+            if (match && bistree_avl(pivot)->hidden) {
+                keep = match;
+            }
+            else if (match) {
+                discard(&task->garbage, match, task->destroy);
+            }
+
+            discard(&task->garbage, pivot, task->destroy);
+            break;
+    }
+
+    if (keep) {
+        task->height = join(halves[0].root, halves[0].height, keep, halves[1].root, halves[1].height, &task->root);
+    }
+    else {
+        task->height = join_pair(halves[0].root, halves[0].height, halves[1].root, halves[1].height, &task->root);
+    }
+
+    gather(&task->garbage, &halves[0].garbage);
+    gather(&task->garbage, &halves[1].garbage);
+}
+
+static void take_spares(BisTree* tree, AvlNode* spares) {
+    AvlNode* last;
+
+    if (!spares) {
+        return;
+    }
+
+    for (last = spares; bitree_right(&last->node); last = (AvlNode*) bitree_right(&last->node)) {
+        continue;
+    }
+
+    bitree_right(&last->node) = (BiTreeNode*) tree->free;
+    tree->free = spares;
+}
+
+static void empty_tree(BisTree* tree) {
+    tree->root = NULL;
+    tree->size = 0;
+    tree->slabs = NULL;
+    tree->used = 0;
+    tree->free = NULL;
+    tree->hidden = 0;
+}
+
+static int combine(BisTree* result, BisTree* tree1, BisTree* tree2, int op, int nthreads) {
+    AvlSetTask task;
+    AvlSlab* slab;
+    int size;
+
+    if (result == tree1 || result == tree2 || tree1 == tree2) {
+        return -1;
+    }
+
+    /* Nodes from both trees are ordered by one compare & prefix, & freed by one destroy */
+    if (tree1->compare != tree2->compare || tree1->prefix != tree2->prefix || tree1->destroy != tree2->destroy) {
+        return -1;
+    }
+
+    bistree_init(result, tree1->compare, tree1->destroy);
+    result->threshold = tree1->threshold;
+    result->prefix = tree1->prefix;
+
+    task.tree = result;
+    task.destroy = tree1->destroy;
+    task.op = op;
+    task.nthreads = nthreads > 0 ? nthreads : 1;
+    task.node1 = bitree_root(tree1);
+    task.height1 = subtree_height(bitree_root(tree1));
+    task.node2 = bitree_root(tree2);
+    task.height2 = subtree_height(bitree_root(tree2));
+
+    set_op(&task);
+
+    size = bistree_size(tree1) + bistree_size(tree2) - task.garbage.count;
+    result->root = task.root;
+    result->size = size;
+    result->hidden = size - count_live(task.root);
+
+    /* The result owns every node from both trees, so it takes both sets of slabs */
+    if (tree1->slabs) {
+        for (slab = tree1->slabs; slab->next; slab = slab->next) {
+            continue;
+        }
+
+        slab->next = tree2->slabs;
+        result->slabs = tree1->slabs;
+        result->used = tree1->used;
+    }
+    else {
+        result->slabs = tree2->slabs;
+        result->used = tree2->used;
+    }
+
+    /* Dropped nodes & both trees' spare nodes can be reused */
+    take_spares(result, tree2->free);
+    take_spares(result, tree1->free);
+    take_spares(result, task.garbage.head);
+
+    /* Don't let the original trees access the combined nodes */
+    empty_tree(tree1);
+    empty_tree(tree2);
+
+    return 0;
+}
+
+int bistree_union(BisTree* result, BisTree* tree1, BisTree* tree2, int nthreads) {
+    return combine(result, tree1, tree2, AVL_UNION, nthreads);
+}
+
+int bistree_intersect(BisTree* result, BisTree* tree1, BisTree* tree2, int nthreads) {
+    return combine(result, tree1, tree2, AVL_INTERSECT, nthreads);
+}
+
+int bistree_difference(BisTree* result, BisTree* tree1, BisTree* tree2, int nthreads) {
+    return combine(result, tree1, tree2, AVL_DIFFERENCE, nthreads);
+}
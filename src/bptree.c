@@ -0,0 +1,560 @@
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "../include/bptree.h"
+
+/* Nodes an insertion can split, more than the height of any tree of int size */
+#define BPTREE_SPLITS 16
+
+/* Nodes allocated before an insertion changes anything, so it can't fail halfway */
+typedef struct {
+    BpNode* nodes[BPTREE_SPLITS];
+    int count;
+} BpSpare;
+
+static BpNode* new_node(int leaf) {
+    BpNode* node;
+
+    node = (BpNode*) malloc(sizeof(BpNode));
+    if (!node) {
+        return NULL;
+    }
+
+    node->leaf = leaf;
+    node->count = 0;
+    node->next = NULL;
+
+    return node;
+}
+
+static int count_keys(const int* keys, int count, int key, int inclusive) {
+#ifdef __SSE2__
+    __m128i probe;
+    __m128i block;
+#endif
+    int below, bits, i;
+
+    below = 0;
+    i = 0;
+
+#ifdef __SSE2__
+    /* Count the keys below the probe four at a time, stopping at the first block that isn't all below */
+    probe = _mm_set1_epi32(key);
+    for (; i + 4 <= count; i += 4) {
+        block = _mm_loadu_si128((const __m128i*) (keys + i));
+
+        if (inclusive) {
+            bits = 15 & ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(block, probe)));
+        }
+        else {
+            bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(probe, block)));
+        }
+
+        below += __builtin_popcount(bits);
+        if (bits != 15) {
+            return below;
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        bits = inclusive ? keys[i] <= key : keys[i] < key;
+        if (!bits) {
+            break;
+        }
+
+        below += 1;
+    }
+
+    return below;
+}
+
+static int count_data(const BpTree* tree, const BpNode* node, const void* data, int inclusive) {
+    int low, high, middle, cmpval;
+
+    /* Binary search for the number of entries below the data */
+    low = 0;
+    high = node->count;
+    while (low < high) {
+        middle = (low + high) / 2;
+        cmpval = tree->compare(node->data[middle], data);
+
+        if (cmpval < 0 || (inclusive && cmpval == 0)) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+static int below(const BpTree* tree, const BpNode* node, const void* data, int key, int inclusive) {
+    if (tree->key) {
+        return count_keys(node->keys, node->count, key, inclusive);
+    }
+
+    return count_data(tree, node, data, inclusive);
+}
+
+static int equal(const BpTree* tree, const BpNode* node, int i, const void* data, int key) {
+    if (tree->key) {
+        return node->keys[i] == key;
+    }
+
+    return tree->compare(node->data[i], data) == 0;
+}
+
+static void open_slot(BpNode* node, int i) {
+    /* Make room for a key at i, with its right-hand child at i + 1 */
+    memmove(node->keys + i + 1, node->keys + i, (node->count - i) * sizeof(int));
+    memmove(node->data + i + 1, node->data + i, (node->count - i) * sizeof(void*));
+
+    if (!node->leaf) {
+        memmove(node->children + i + 2, node->children + i + 1, (node->count - i) * sizeof(BpNode*));
+    }
+
+    node->count += 1;
+}
+
+static void close_slot(BpNode* node, int i) {
+    /* Drop the key at i along with its right-hand child */
+    memmove(node->keys + i, node->keys + i + 1, (node->count - i - 1) * sizeof(int));
+    memmove(node->data + i, node->data + i + 1, (node->count - i - 1) * sizeof(void*));
+
+    if (!node->leaf) {
+        memmove(node->children + i + 1, node->children + i + 2, (node->count - i - 1) * sizeof(BpNode*));
+    }
+
+    node->count -= 1;
+}
+
+static int reserve(BpSpare* spare, int count) {
+    if (count > BPTREE_SPLITS) {
+        return -1;
+    }
+
+    for (spare->count = 0; spare->count < count; spare->count++) {
+        spare->nodes[spare->count] = new_node(0);
+        if (!spare->nodes[spare->count]) {
+            while (spare->count > 0) {
+                free(spare->nodes[--spare->count]);
+            }
+
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void split(BpNode* node, int i, const void* data, int key, BpNode* child, BpSpare* spare, BpNode** right, void** sepdata, int* sepkey) {
+    int keys[BPTREE_ORDER + 1];
+    void* items[BPTREE_ORDER + 1];
+    BpNode* children[BPTREE_ORDER + 2];
+    int half, skip;
+
+    *right = spare->nodes[--spare->count];
+    (*right)->leaf = node->leaf;
+
+    /* Lay out the full node plus the new entry, then deal it into two halves */
+    memcpy(keys, node->keys, i * sizeof(int));
+    memcpy(items, node->data, i * sizeof(void*));
+    keys[i] = key;
+    items[i] = (void*) data;
+    memcpy(keys + i + 1, node->keys + i, (BPTREE_ORDER - i) * sizeof(int));
+    memcpy(items + i + 1, node->data + i, (BPTREE_ORDER - i) * sizeof(void*));
+
+    if (!node->leaf) {
+        memcpy(children, node->children, (i + 1) * sizeof(BpNode*));
+        children[i + 1] = child;
+        memcpy(children + i + 2, node->children + i + 1, (BPTREE_ORDER - i) * sizeof(BpNode*));
+    }
+
+    half = (BPTREE_ORDER + 1) / 2;
+
+    /* An inner node passes its middle key up rather than keeping a copy */
+    skip = node->leaf ? 0 : 1;
+    *sepdata = items[half];
+    *sepkey = keys[half];
+
+    node->count = half;
+    memcpy(node->keys, keys, half * sizeof(int));
+    memcpy(node->data, items, half * sizeof(void*));
+
+    (*right)->count = BPTREE_ORDER + 1 - half - skip;
+    memcpy((*right)->keys, keys + half + skip, (*right)->count * sizeof(int));
+    memcpy((*right)->data, items + half + skip, (*right)->count * sizeof(void*));
+
+    if (node->leaf) {
+        (*right)->next = node->next;
+        node->next = *right;
+    }
+    else {
+        memcpy(node->children, children, (half + 1) * sizeof(BpNode*));
+        memcpy((*right)->children, children + half + 1, ((*right)->count + 1) * sizeof(BpNode*));
+    }
+}
+
+static int insert(BpTree* tree, BpNode* node, const void* data, int key, int full, BpSpare* spare, BpNode** right, void** sepdata, int* sepkey) {
+    BpNode* child;
+    void* childdata;
+    int childkey, retval, i;
+
+    *right = NULL;
+
+    if (node->leaf) {
+        i = below(tree, node, data, key, 0);
+
+        /* Don't allow duplicates */
+        if (i < node->count && equal(tree, node, i, data, key)) {
+            return 1;
+        }
+
+        if (node->count == BPTREE_ORDER) {
+            /* The split ripples up through every full ancestor in a row */
+            if (reserve(spare, full + 1)) {
+                return -1;
+            }
+
+            split(node, i, data, key, NULL, spare, right, sepdata, sepkey);
+            return 0;
+        }
+
+        open_slot(node, i);
+        node->keys[i] = key;
+        node->data[i] = (void*) data;
+        return 0;
+    }
+
+    /* Keys equal to a separator live to its right */
+    i = below(tree, node, data, key, 1);
+    full = node->count == BPTREE_ORDER ? full + 1 : 0;
+    retval = insert(tree, node->children[i], data, key, full, spare, &child, &childdata, &childkey);
+    if (retval || !child) {
+        return retval;
+    }
+
+    /* Take in the separator of a child that split */
+    if (node->count == BPTREE_ORDER) {
+        split(node, i, childdata, childkey, child, spare, right, sepdata, sepkey);
+        return 0;
+    }
+
+    open_slot(node, i);
+    node->keys[i] = childkey;
+    node->data[i] = childdata;
+    node->children[i + 1] = child;
+    return 0;
+}
+
+static void borrow_left(BpNode* node, int i) {
+    BpNode* child = node->children[i];
+    BpNode* left = node->children[i - 1];
+
+    memmove(child->keys + 1, child->keys, child->count * sizeof(int));
+    memmove(child->data + 1, child->data, child->count * sizeof(void*));
+
+    if (child->leaf) {
+        /* Move the last entry across, which becomes the new separator */
+        child->keys[0] = left->keys[left->count - 1];
+        child->data[0] = left->data[left->count - 1];
+        node->keys[i - 1] = child->keys[0];
+        node->data[i - 1] = child->data[0];
+    }
+    else {
+        /* Rotate the separator down & the left sibling's last key up */
+        memmove(child->children + 1, child->children, (child->count + 1) * sizeof(BpNode*));
+        child->keys[0] = node->keys[i - 1];
+        child->data[0] = node->data[i - 1];
+        child->children[0] = left->children[left->count];
+        node->keys[i - 1] = left->keys[left->count - 1];
+        node->data[i - 1] = left->data[left->count - 1];
+    }
+
+    child->count += 1;
+    left->count -= 1;
+}
+
+static void borrow_right(BpNode* node, int i) {
+    BpNode* child = node->children[i];
+    BpNode* right = node->children[i + 1];
+
+    if (child->leaf) {
+        /* Move the first entry across, the next one becoming the separator */
+        child->keys[child->count] = right->keys[0];
+        child->data[child->count] = right->data[0];
+        memmove(right->keys, right->keys + 1, (right->count - 1) * sizeof(int));
+        memmove(right->data, right->data + 1, (right->count - 1) * sizeof(void*));
+        node->keys[i] = right->keys[0];
+        node->data[i] = right->data[0];
+    }
+    else {
+        /* Rotate the separator down & the right sibling's first key up */
+        child->keys[child->count] = node->keys[i];
+        child->data[child->count] = node->data[i];
+        child->children[child->count + 1] = right->children[0];
+        node->keys[i] = right->keys[0];
+        node->data[i] = right->data[0];
+        memmove(right->keys, right->keys + 1, (right->count - 1) * sizeof(int));
+        memmove(right->data, right->data + 1, (right->count - 1) * sizeof(void*));
+        memmove(right->children, right->children + 1, right->count * sizeof(BpNode*));
+    }
+
+    child->count += 1;
+    right->count -= 1;
+}
+
+static void merge(BpNode* node, int i) {
+    BpNode* left = node->children[i];
+    BpNode* right = node->children[i + 1];
+
+    if (left->leaf) {
+        left->next = right->next;
+    }
+    else {
+        /* The separator comes down between the two halves */
+        left->keys[left->count] = node->keys[i];
+        left->data[left->count] = node->data[i];
+        memcpy(left->children + left->count + 1, right->children, (right->count + 1) * sizeof(BpNode*));
+        left->count += 1;
+    }
+
+    memcpy(left->keys + left->count, right->keys, right->count * sizeof(int));
+    memcpy(left->data + left->count, right->data, right->count * sizeof(void*));
+    left->count += right->count;
+
+    close_slot(node, i);
+    free(right);
+}
+
+static void rebalance(BpNode* node, int i) {
+    /* Borrow from a sibling with keys to spare, otherwise merge with one */
+    if (i > 0 && node->children[i - 1]->count > BPTREE_MIN) {
+        borrow_left(node, i);
+    }
+    else if (i < node->count && node->children[i + 1]->count > BPTREE_MIN) {
+        borrow_right(node, i);
+    }
+    else if (i > 0) {
+        merge(node, i - 1);
+    }
+    else {
+        merge(node, i);
+    }
+}
+
+static int remove_entry(BpTree* tree, BpNode* node, void** data, int key) {
+    const BpNode* leftmost;
+    int retval, i;
+
+    if (node->leaf) {
+        i = below(tree, node, *data, key, 0);
+        if (i == node->count || !equal(tree, node, i, *data, key)) {
+            /* Data not found */
+            return -1;
+        }
+
+        *data = node->data[i];
+        close_slot(node, i);
+        return 0;
+    }
+
+    i = below(tree, node, *data, key, 1);
+    retval = remove_entry(tree, node->children[i], data, key);
+    if (retval) {
+        return retval;
+    }
+
+    /* Don't leave a separator pointing at data that's leaving the tree */
+    /* Refresh it before rebalancing, which may rotate it down into the child */
+    if (i > 0 && equal(tree, node, i - 1, *data, key)) {
+        for (leftmost = node->children[i]; !leftmost->leaf; leftmost = leftmost->children[0]) {
+            ;
+        }
+
+        node->keys[i - 1] = leftmost->keys[0];
+        node->data[i - 1] = leftmost->data[0];
+    }
+
+    if (node->children[i]->count < BPTREE_MIN) {
+        rebalance(node, i);
+    }
+
+    return 0;
+}
+
+static void destroy_node(BpTree* tree, BpNode* node) {
+    int i;
+
+    if (node->leaf) {
+        for (i = 0; tree->destroy && i < node->count; i++) {
+            /* Call a user-defined function to free dynamically allocated data */
+            tree->destroy(node->data[i]);
+        }
+    }
+    else {
+        for (i = 0; i <= node->count; i++) {
+            destroy_node(tree, node->children[i]);
+        }
+    }
+
+    free(node);
+}
+
+void bptree_init(BpTree* tree,
+                 int (*compare)(const void* key1, const void* key2),
+                 void (*destroy)(void* data)) {
+    tree->size = 0;
+    tree->compare = compare;
+    tree->key = NULL;
+    tree->destroy = destroy;
+    tree->root = NULL;
+}
+
+void bptree_init_int(BpTree* tree, int (*key)(const void* data), void (*destroy)(void* data)) {
+    bptree_init(tree, NULL, destroy);
+    tree->key = key;
+}
+
+void bptree_destroy(BpTree* tree) {
+    if (tree->root) {
+        destroy_node(tree, tree->root);
+    }
+
+    memset(tree, 0, sizeof(BpTree));
+}
+
+int bptree_insert(BpTree* tree, const void* data) {
+    BpSpare spare;
+    BpNode* right;
+    BpNode* root;
+    void* sepdata;
+    int key, sepkey, retval;
+
+    if (!tree->root) {
+        /* Handle insertion into an empty tree */
+        tree->root = new_node(1);
+        if (!tree->root) {
+            return -1;
+        }
+    }
+
+    /* Count the root as having a full parent, which stands for a new root */
+    key = tree->key ? tree->key(data) : 0;
+    spare.count = 0;
+    retval = insert(tree, tree->root, data, key, 1, &spare, &right, &sepdata, &sepkey);
+    if (retval) {
+        return retval;
+    }
+
+    if (right) {
+        /* The root split, so grow the tree by a level */
+        root = spare.nodes[--spare.count];
+        root->count = 1;
+        root->keys[0] = sepkey;
+        root->data[0] = sepdata;
+        root->children[0] = tree->root;
+        root->children[1] = right;
+        tree->root = root;
+    }
+
+    tree->size += 1;
+    return 0;
+}
+
+int bptree_remove(BpTree* tree, void** data) {
+    BpNode* root;
+    int key;
+
+    if (!tree->root) {
+        return -1;
+    }
+
+    key = tree->key ? tree->key(*data) : 0;
+    if (remove_entry(tree, tree->root, data, key)) {
+        return -1;
+    }
+
+    /* Shrink the tree by a level once the root runs out of keys */
+    root = tree->root;
+    if (!root->count) {
+        tree->root = root->leaf ? NULL : root->children[0];
+        free(root);
+    }
+
+    tree->size -= 1;
+    return 0;
+}
+
+int bptree_lookup(const BpTree* tree, void** data) {
+    const BpNode* node;
+    int key, i;
+
+    node = tree->root;
+    if (!node) {
+        return -1;
+    }
+
+    key = tree->key ? tree->key(*data) : 0;
+    while (!node->leaf) {
+        node = node->children[below(tree, node, *data, key, 1)];
+    }
+
+    i = below(tree, node, *data, key, 0);
+    if (i == node->count || !equal(tree, node, i, *data, key)) {
+        /* Data not found */
+        return -1;
+    }
+
+    /* Pass the data back from the tree */
+    *data = node->data[i];
+    return 0;
+}
+
+void bptree_seek(const BpTree* tree, BpCursor* cursor, const void* data) {
+    const BpNode* node;
+    int key;
+
+    node = tree->root;
+    cursor->leaf = NULL;
+    cursor->index = 0;
+    if (!node) {
+        return;
+    }
+
+    /* Without data, start from the smallest entry */
+    if (!data) {
+        while (!node->leaf) {
+            node = node->children[0];
+        }
+
+        cursor->leaf = node;
+        return;
+    }
+
+    key = tree->key ? tree->key(data) : 0;
+    while (!node->leaf) {
+        node = node->children[below(tree, node, data, key, 1)];
+    }
+
+    cursor->leaf = node;
+    cursor->index = below(tree, node, data, key, 0);
+}
+
+int bptree_next(BpCursor* cursor, void** data) {
+    /* Step along the chain of leaves, skipping to the next when one runs out */
+    while (cursor->leaf && cursor->index >= cursor->leaf->count) {
+        cursor->leaf = cursor->leaf->next;
+        cursor->index = 0;
+    }
+
+    if (!cursor->leaf) {
+        return -1;
+    }
+
+    *data = cursor->leaf->data[cursor->index++];
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <string.h>
+#include "../include/centrality.h"
+#include "../include/parallel.h"
+
+/* Per-thread state for one single-source search at a time */
+typedef struct {
+    int* dist;
+    int* order;
+    double* sigma;
+    double* delta;
+    double* centrality;
+} Workspace;
+
+typedef struct {
+    const CsrGraph* csr;
+    const int* sources;
+    Workspace* workspaces;
+} Brandes;
+
+static void accumulate(const CsrGraph* csr, Workspace* ws, int source) {
+    const int* adj;
+    int head, tail, u, w, i;
+
+    /* Count shortest paths from the source breadth first */
+    ws->dist[source] = 0;
+    ws->sigma[source] = 1.0;
+    ws->order[0] = source;
+    head = 0;
+    tail = 1;
+
+    while (head < tail) {
+        u = ws->order[head++];
+        adj = csr_neighbours(csr, u);
+
+        for (i = 0; i < csr_degree(csr, u); i++) {
+            w = adj[i];
+
+            if (ws->dist[w] < 0) {
+                ws->dist[w] = ws->dist[u] + 1;
+                ws->order[tail++] = w;
+            }
+
+            if (ws->dist[w] == ws->dist[u] + 1) {
+                ws->sigma[w] += ws->sigma[u];
+            }
+        }
+    }
+
+    /* Accumulate dependencies in reverse order, pulling from successors */
+    for (head = tail - 1; head >= 0; head--) {
+        u = ws->order[head];
+        adj = csr_neighbours(csr, u);
+
+        for (i = 0; i < csr_degree(csr, u); i++) {
+            w = adj[i];
+            if (ws->dist[w] == ws->dist[u] + 1) {
+                ws->delta[u] += ws->sigma[u] / ws->sigma[w] * (1.0 + ws->delta[w]);
+            }
+        }
+
+        if (u != source) {
+            ws->centrality[u] += ws->delta[u];
+        }
+    }
+
+    /* Reset only the vertices this search reached */
+    for (head = 0; head < tail; head++) {
+        u = ws->order[head];
+        ws->dist[u] = -1;
+        ws->sigma[u] = 0.0;
+        ws->delta[u] = 0.0;
+    }
+}
+
+static void run_sources(int begin, int end, int thread, void* arg) {
+    const Brandes* brandes = arg;
+    int i;
+
+    for (i = begin; i < end; i++) {
+        accumulate(brandes->csr, &brandes->workspaces[thread], brandes->sources[i]);
+    }
+}
+
+static void destroy_workspaces(Workspace* workspaces, int nthreads) {
+    int t;
+
+    for (t = 0; t < nthreads; t++) {
+        free(workspaces[t].dist);
+        free(workspaces[t].order);
+        free(workspaces[t].sigma);
+        free(workspaces[t].delta);
+        free(workspaces[t].centrality);
+    }
+
+    free(workspaces);
+}
+
+int betweenness(const CsrGraph* csr, int samples, unsigned int seed, int nthreads, double* centrality) {
+    Workspace* workspaces;
+    Brandes brandes;
+    int* sources;
+    double scale;
+    int vcount, nsources, tmp, t, v, i, j;
+
+    vcount = csr_vcount(csr);
+    nthreads = parallel_threads(nthreads);
+
+    workspaces = calloc(nthreads, sizeof(Workspace));
+    sources = malloc((vcount ? vcount : 1) * sizeof(int));
+    if (!workspaces || !sources) {
+        free(workspaces);
+        free(sources);
+        return -1;
+    }
+
+    for (t = 0; t < nthreads; t++) {
+        workspaces[t].dist = malloc((vcount ? vcount : 1) * sizeof(int));
+        workspaces[t].order = malloc((vcount ? vcount : 1) * sizeof(int));
+        workspaces[t].sigma = calloc(vcount ? vcount : 1, sizeof(double));
+        workspaces[t].delta = calloc(vcount ? vcount : 1, sizeof(double));
+        workspaces[t].centrality = calloc(vcount ? vcount : 1, sizeof(double));
+
+        if (!workspaces[t].dist || !workspaces[t].order || !workspaces[t].sigma
+            || !workspaces[t].delta || !workspaces[t].centrality) {
+            destroy_workspaces(workspaces, nthreads);
+            free(sources);
+            return -1;
+        }
+
+        memset(workspaces[t].dist, -1, vcount * sizeof(int));
+    }
+
+    /* Use every vertex as a source, or a random sample of k of them */
+    for (v = 0; v < vcount; v++) {
+        sources[v] = v;
+    }
+
+    nsources = vcount;
+    if (samples > 0 && samples < vcount) {
+        for (i = 0; i < samples; i++) {
+            seed = seed * 1103515245 + 12345;
+            j = i + (int) ((seed >> 8) % (unsigned int) (vcount - i));
+            tmp = sources[i];
+            sources[i] = sources[j];
+            sources[j] = tmp;
+        }
+        nsources = samples;
+    }
+
+    brandes.csr = csr;
+    brandes.sources = sources;
+    brandes.workspaces = workspaces;
+
+    parallel_for(nsources, 1, nthreads, run_sources, &brandes);
+
+    /* Sum the per-thread scores, scaling up a sampled estimate */
+    scale = nsources ? (double) vcount / nsources : 0.0;
+    for (v = 0; v < vcount; v++) {
+        centrality[v] = 0.0;
+        for (t = 0; t < nthreads; t++) {
+            centrality[v] += workspaces[t].centrality[v];
+        }
+        centrality[v] *= scale;
+    }
+
+    destroy_workspaces(workspaces, nthreads);
+    free(sources);
+    return 0;
+}
@@ -0,0 +1,597 @@
+#include <stdint.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "../include/csr.h"
+
+/* Size ratio beyond which intersection gallops through the larger set */
+#define CSR_GALLOP_RATIO 32
+
+static unsigned int hash_pointer(const void* data) {
+    uint64_t key = (uint64_t) (uintptr_t) data;
+
+    /* Fibonacci hashing spreads aligned pointers across the table */
+    key ^= key >> 33;
+    key *= 0x9e3779b97f4a7c15ULL;
+    return (unsigned int) (key >> 32);
+}
+
+static int index_vertices(CsrGraph* csr) {
+    unsigned int slot;
+    int nslots;
+    int v;
+
+    /* Keep the table at most half full so probe sequences stay short */
+    nslots = 1;
+    while (nslots < 2 * csr->vcount) {
+        nslots <<= 1;
+    }
+
+    csr->slots = malloc(nslots * sizeof(int));
+    if (!csr->slots) {
+        return -1;
+    }
+
+    memset(csr->slots, -1, nslots * sizeof(int));
+    csr->nslots = nslots;
+
+    for (v = 0; v < csr->vcount; v++) {
+        slot = hash_pointer(csr->vertices[v]) & (nslots - 1);
+        while (csr->slots[slot] != -1) {
+            slot = (slot + 1) & (nslots - 1);
+        }
+        csr->slots[slot] = v;
+    }
+
+    return 0;
+}
+
+static int alloc_arrays(CsrGraph* csr, int vcount, int ecount) {
+    memset(csr, 0, sizeof(CsrGraph));
+
+    csr->vertices = calloc(vcount ? vcount : 1, sizeof(void*));
+    csr->offsets = calloc(vcount + 1, sizeof(int));
+    csr->targets = malloc((ecount ? ecount : 1) * sizeof(int));
+
+    if (!csr->vertices || !csr->offsets || !csr->targets) {
+        csr_destroy(csr);
+        return -1;
+    }
+
+    csr->vcount = vcount;
+    csr->ecount = ecount;
+    return 0;
+}
+
+static int compare_ids(const void* key1, const void* key2) {
+    int id1 = *(const int*) key1;
+    int id2 = *(const int*) key2;
+
+    return (id1 > id2) - (id1 < id2);
+}
+
+static void sort_rows(CsrGraph* csr) {
+    int begin, end, e, v, i;
+
+    /* Sort each row & squeeze out repeated edges as the rows close up */
+    e = 0;
+    begin = 0;
+    for (v = 0; v < csr->vcount; v++) {
+        end = csr->offsets[v + 1];
+        qsort(csr->targets + begin, end - begin, sizeof(int), compare_ids);
+
+        csr->offsets[v] = e;
+        for (i = begin; i < end; i++) {
+            if (i == begin || csr->targets[i] != csr->targets[e - 1]) {
+                csr->targets[e++] = csr->targets[i];
+            }
+        }
+
+        begin = end;
+    }
+
+    csr->offsets[csr->vcount] = e;
+    csr->ecount = e;
+}
+
+int csr_build(CsrGraph* csr, const Graph* graph) {
+    ListElmt* element;
+    ListElmt* member;
+    AdjList* adjlist;
+    int ecount, v, e, id;
+
+    /* Count the edges actually held in the adjacency sets */
+    ecount = 0;
+    for (element = list_head(&graph_adjlists(graph)); element != NULL; element = list_next(element)) {
+        ecount += set_size(&((AdjList*) list_data(element))->adjacent);
+    }
+
+    if (alloc_arrays(csr, graph_vcount(graph), ecount)) {
+        return -1;
+    }
+
+    csr->match = graph->match;
+
+    /* Number the vertices in the order of the adjacency lists */
+    v = 0;
+    for (element = list_head(&graph_adjlists(graph)); element != NULL; element = list_next(element)) {
+        adjlist = list_data(element);
+        csr->vertices[v] = adjlist->vertex;
+        csr->offsets[v + 1] = csr->offsets[v] + set_size(&adjlist->adjacent);
+        v++;
+    }
+
+    if (index_vertices(csr)) {
+        csr_destroy(csr);
+        return -1;
+    }
+
+    /* Translate each adjacent vertex into its number */
+    e = 0;
+    for (element = list_head(&graph_adjlists(graph)); element != NULL; element = list_next(element)) {
+        adjlist = list_data(element);
+
+        for (member = list_head(&adjlist->adjacent); member != NULL; member = list_next(member)) {
+            id = csr_vertex_id(csr, list_data(member));
+            if (id < 0) {
+                csr_destroy(csr);
+                return -1;
+            }
+            csr->targets[e++] = id;
+        }
+    }
+
+    sort_rows(csr);
+    return 0;
+}
+
+int csr_from_edges(CsrGraph* csr, int vcount, const int* edges, int ecount) {
+    int* fill;
+    int e, v;
+
+    /* Validate the edge list before allocating anything */
+    for (e = 0; e < 2 * ecount; e++) {
+        if (edges[e] < 0 || edges[e] >= vcount) {
+            return -1;
+        }
+    }
+
+    if (alloc_arrays(csr, vcount, ecount)) {
+        return -1;
+    }
+
+    fill = malloc((vcount ? vcount : 1) * sizeof(int));
+    if (!fill) {
+        csr_destroy(csr);
+        return -1;
+    }
+
+    /* Count out-degrees, then scatter the targets into place */
+    for (e = 0; e < ecount; e++) {
+        csr->offsets[edges[2 * e] + 1] += 1;
+    }
+
+    for (v = 0; v < vcount; v++) {
+        csr->offsets[v + 1] += csr->offsets[v];
+        fill[v] = csr->offsets[v];
+    }
+
+    for (e = 0; e < ecount; e++) {
+        csr->targets[fill[edges[2 * e]]++] = edges[2 * e + 1];
+    }
+
+    free(fill);
+    sort_rows(csr);
+    return 0;
+}
+
+void csr_destroy(CsrGraph* csr) {
+    free(csr->vertices);
+    free(csr->offsets);
+    free(csr->targets);
+    free(csr->slots);
+    memset(csr, 0, sizeof(CsrGraph));
+}
+
+int csr_transpose(CsrGraph* transposed, const CsrGraph* csr) {
+    const int* adj;
+    int* fill;
+    int u, v, i;
+
+    if (alloc_arrays(transposed, csr->vcount, csr->ecount)) {
+        return -1;
+    }
+
+    fill = malloc((csr->vcount ? csr->vcount : 1) * sizeof(int));
+    if (!fill) {
+        csr_destroy(transposed);
+        return -1;
+    }
+
+    transposed->match = csr->match;
+    memcpy(transposed->vertices, csr->vertices, csr->vcount * sizeof(void*));
+
+    /* Count in-degrees, then scatter each edge reversed */
+    for (i = 0; i < csr->ecount; i++) {
+        transposed->offsets[csr->targets[i] + 1] += 1;
+    }
+
+    for (v = 0; v < csr->vcount; v++) {
+        transposed->offsets[v + 1] += transposed->offsets[v];
+        fill[v] = transposed->offsets[v];
+    }
+
+    /* Sources are scattered in ascending order, so each row comes out sorted */
+    for (u = 0; u < csr->vcount; u++) {
+        adj = csr_neighbours(csr, u);
+        for (i = 0; i < csr_degree(csr, u); i++) {
+            transposed->targets[fill[adj[i]]++] = u;
+        }
+    }
+
+    free(fill);
+
+    if (csr->slots && index_vertices(transposed)) {
+        csr_destroy(transposed);
+        return -1;
+    }
+
+    return 0;
+}
+
+int csr_vertex_id(const CsrGraph* csr, const void* data) {
+    unsigned int slot;
+    int v;
+
+    /* Try the identity of the pointer first */
+    if (csr->slots) {
+        slot = hash_pointer(data) & (csr->nslots - 1);
+        while (csr->slots[slot] != -1) {
+            if (csr->vertices[csr->slots[slot]] == data) {
+                return csr->slots[slot];
+            }
+            slot = (slot + 1) & (csr->nslots - 1);
+        }
+    }
+
+    /* Fall back to matching vertices the way the graph does */
+    if (csr->match) {
+        for (v = 0; v < csr->vcount; v++) {
+            if (csr->match(data, csr->vertices[v])) {
+                return v;
+            }
+        }
+    }
+
+    return -1;
+}
+
+static void sort_by_degree(const CsrGraph* csr, int* ids, int n) {
+    int gap, i, j, id;
+
+    /* Shell sort into ascending degree; neighbour runs are mostly short */
+    for (gap = n / 2; gap > 0; gap /= 2) {
+        for (i = gap; i < n; i++) {
+            id = ids[i];
+            for (j = i; j >= gap && csr_degree(csr, ids[j - gap]) > csr_degree(csr, id); j -= gap) {
+                ids[j] = ids[j - gap];
+            }
+            ids[j] = id;
+        }
+    }
+}
+
+static int order_degree(const CsrGraph* csr, int* iperm, int hubs_only);
+
+static int order_bfs(const CsrGraph* csr, int* iperm, int by_degree) {
+    unsigned char* visited;
+    int* starts;
+    const int* adj;
+    int head, tail, first, s, u, i, e;
+
+    visited = calloc(csr->vcount ? csr->vcount : 1, 1);
+    starts = malloc((csr->vcount ? csr->vcount : 1) * sizeof(int));
+    if (!visited || !starts) {
+        free(visited);
+        free(starts);
+        return -1;
+    }
+
+    /* Cuthill-McKee starts each component from a vertex of least degree */
+    if (by_degree) {
+        if (order_degree(csr, starts, 0)) {
+            free(visited);
+            free(starts);
+            return -1;
+        }
+    }
+    else {
+        for (i = 0; i < csr->vcount; i++) {
+            starts[csr->vcount - 1 - i] = i;
+        }
+    }
+
+    /* The permutation doubles as the breadth-first queue */
+    head = tail = 0;
+    for (i = csr->vcount - 1; i >= 0; i--) {
+        s = starts[i];
+        if (visited[s]) {
+            continue;
+        }
+
+        visited[s] = 1;
+        iperm[tail++] = s;
+
+        while (head < tail) {
+            u = iperm[head++];
+            adj = csr_neighbours(csr, u);
+            first = tail;
+
+            for (e = 0; e < csr_degree(csr, u); e++) {
+                if (!visited[adj[e]]) {
+                    visited[adj[e]] = 1;
+                    iperm[tail++] = adj[e];
+                }
+            }
+
+            if (by_degree) {
+                sort_by_degree(csr, iperm + first, tail - first);
+            }
+        }
+    }
+
+    free(visited);
+    free(starts);
+    return 0;
+}
+
+static int order_degree(const CsrGraph* csr, int* iperm, int hubs_only) {
+    int* count;
+    int maxdeg, threshold, deg, pos, v;
+
+    /* Only vertices above the average degree are moved when clustering hubs */
+    threshold = hubs_only && csr->vcount ? csr->ecount / csr->vcount : -1;
+
+    maxdeg = 0;
+    for (v = 0; v < csr->vcount; v++) {
+        if (csr_degree(csr, v) > maxdeg) {
+            maxdeg = csr_degree(csr, v);
+        }
+    }
+
+    count = calloc(maxdeg + 2, sizeof(int));
+    if (!count) {
+        return -1;
+    }
+
+    /* Stable counting sort into descending degree */
+    for (v = 0; v < csr->vcount; v++) {
+        deg = csr_degree(csr, v);
+        if (deg > threshold) {
+            count[maxdeg - deg + 1] += 1;
+        }
+    }
+
+    for (deg = 1; deg <= maxdeg + 1; deg++) {
+        count[deg] += count[deg - 1];
+    }
+
+    pos = count[maxdeg + 1];
+    for (v = 0; v < csr->vcount; v++) {
+        deg = csr_degree(csr, v);
+        if (deg > threshold) {
+            iperm[count[maxdeg - deg]++] = v;
+        }
+        else {
+            /* Everything else keeps its original relative order */
+            iperm[pos++] = v;
+        }
+    }
+
+    free(count);
+    return 0;
+}
+
+int csr_reorder(CsrGraph* reordered, const CsrGraph* csr, CsrOrder order, int* perm, int* iperm) {
+    const int* adj;
+    int* targets;
+    int rc, v, i, tmp;
+
+    switch (order) {
+        case CSR_ORDER_BFS:
+            rc = order_bfs(csr, iperm, 0);
+            break;
+
+        case CSR_ORDER_RCM:
+            rc = order_bfs(csr, iperm, 1);
+            if (!rc) {
+                /* Reverse the Cuthill-McKee order */
+                for (i = 0; i < csr->vcount / 2; i++) {
+                    tmp = iperm[i];
+                    iperm[i] = iperm[csr->vcount - 1 - i];
+                    iperm[csr->vcount - 1 - i] = tmp;
+                }
+            }
+            break;
+
+        case CSR_ORDER_DEGREE:
+            rc = order_degree(csr, iperm, 0);
+            break;
+
+        case CSR_ORDER_HUB:
+            rc = order_degree(csr, iperm, 1);
+            break;
+
+        default:
+            rc = -1;
+            break;
+    }
+
+    if (rc) {
+        return -1;
+    }
+
+    for (v = 0; v < csr->vcount; v++) {
+        perm[iperm[v]] = v;
+    }
+
+    /* Lay out the relabeled graph in its new order */
+    if (alloc_arrays(reordered, csr->vcount, csr->ecount)) {
+        return -1;
+    }
+
+    reordered->match = csr->match;
+
+    for (v = 0; v < csr->vcount; v++) {
+        adj = csr_neighbours(csr, iperm[v]);
+        reordered->vertices[v] = csr->vertices[iperm[v]];
+        reordered->offsets[v + 1] = reordered->offsets[v] + csr_degree(csr, iperm[v]);
+
+        targets = reordered->targets + reordered->offsets[v];
+        for (i = 0; i < csr_degree(csr, iperm[v]); i++) {
+            targets[i] = perm[adj[i]];
+        }
+
+        /* Neighbours in ascending order are visited in memory order */
+        qsort(targets, csr_degree(csr, iperm[v]), sizeof(int), compare_ids);
+    }
+
+    if (csr->slots && index_vertices(reordered)) {
+        csr_destroy(reordered);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int gallop(const int* set, int size, int from, int id) {
+    int low, high, step;
+
+    /* Find the first position at or after from holding an id >= id */
+    step = 1;
+    low = from;
+    high = from;
+    while (high < size && set[high] < id) {
+        low = high + 1;
+        high += step;
+        step <<= 1;
+    }
+
+    if (high > size) {
+        high = size;
+    }
+
+    while (low < high) {
+        step = low + (high - low) / 2;
+        if (set[step] < id) {
+            low = step + 1;
+        }
+        else {
+            high = step;
+        }
+    }
+
+    return low;
+}
+
+static int intersect_gallop(const int* small, int nsmall, const int* large, int nlarge, int* common) {
+    int count, i, j;
+
+    count = 0;
+    j = 0;
+    for (i = 0; i < nsmall && j < nlarge; i++) {
+        j = gallop(large, nlarge, j, small[i]);
+        if (j < nlarge && large[j] == small[i]) {
+            if (common) {
+                common[count] = small[i];
+            }
+            count++;
+            j++;
+        }
+    }
+
+    return count;
+}
+
+static int intersect_merge(const int* set1, int size1, const int* set2, int size2, int* common) {
+    int count, i, j;
+
+    count = 0;
+    i = j = 0;
+
+#ifdef __SSE2__
+    /* Compare blocks of four against all four rotations of the other block */
+    if (!common) {
+        __m128i block1, block2, match;
+        int last1, last2;
+
+        while (i + 4 <= size1 && j + 4 <= size2) {
+            block1 = _mm_loadu_si128((const __m128i*) (set1 + i));
+            block2 = _mm_loadu_si128((const __m128i*) (set2 + j));
+
+            match = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi32(block1, block2),
+                             _mm_cmpeq_epi32(block1, _mm_shuffle_epi32(block2, _MM_SHUFFLE(0, 3, 2, 1)))),
+                _mm_or_si128(_mm_cmpeq_epi32(block1, _mm_shuffle_epi32(block2, _MM_SHUFFLE(1, 0, 3, 2))),
+                             _mm_cmpeq_epi32(block1, _mm_shuffle_epi32(block2, _MM_SHUFFLE(2, 1, 0, 3)))));
+
+            count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(match)));
+
+            /* Advance whichever block ends first, or both on a tie */
+            last1 = set1[i + 3];
+            last2 = set2[j + 3];
+
+            if (last1 <= last2) {
+                i += 4;
+            }
+
+            if (last2 <= last1) {
+                j += 4;
+            }
+        }
+    }
+#endif
+
+    /* Merge whatever is left one id at a time */
+    while (i < size1 && j < size2) {
+        if (set1[i] < set2[j]) {
+            i++;
+        }
+        else if (set1[i] > set2[j]) {
+            j++;
+        }
+        else {
+            if (common) {
+                common[count] = set1[i];
+            }
+            count++;
+            i++;
+            j++;
+        }
+    }
+
+    return count;
+}
+
+int csr_intersect(const int* set1, int size1, const int* set2, int size2, int* common) {
+    /* Gallop when one set is much smaller than the other */
+    if ((long) size1 * CSR_GALLOP_RATIO < size2) {
+        return intersect_gallop(set1, size1, set2, size2, common);
+    }
+
+    if ((long) size2 * CSR_GALLOP_RATIO < size1) {
+        return intersect_gallop(set2, size2, set1, size1, common);
+    }
+
+    return intersect_merge(set1, size1, set2, size2, common);
+}
+
+int csr_common_neighbours(const CsrGraph* csr, int u, int v, int* common) {
+    if (u < 0 || u >= csr->vcount || v < 0 || v >= csr->vcount) {
+        return -1;
+    }
+
+    return csr_intersect(csr_neighbours(csr, u), csr_degree(csr, u),
+                         csr_neighbours(csr, v), csr_degree(csr, v), common);
+}
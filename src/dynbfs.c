@@ -0,0 +1,354 @@
+#include <limits.h>
+#include <string.h>
+#include "../include/dynbfs.h"
+
+/* Vertex whose hop count is being repaired after a deletion */
+typedef struct {
+    int dist;
+    int old;
+    int id;
+} DynSeed;
+
+static int adj_append(DynAdj* adj, int id) {
+    int* ids;
+    int capacity;
+
+    if (adj->size == adj->capacity) {
+        capacity = adj->capacity ? 2 * adj->capacity : 4;
+        ids = realloc(adj->ids, capacity * sizeof(int));
+        if (!ids) {
+            return -1;
+        }
+
+        adj->ids = ids;
+        adj->capacity = capacity;
+    }
+
+    adj->ids[adj->size++] = id;
+    return 0;
+}
+
+static int adj_remove(DynAdj* adj, int id) {
+    int i;
+
+    for (i = 0; i < adj->size; i++) {
+        if (adj->ids[i] == id) {
+            /* Order doesn't matter, so fill the hole with the last id */
+            adj->ids[i] = adj->ids[--adj->size];
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static void search(DynBfs* dynbfs) {
+    DynAdj* adj;
+    int head, tail, u, i;
+
+    for (i = 0; i < dynbfs->vcount; i++) {
+        dynbfs->dist[i] = -1;
+        dynbfs->pred[i] = -1;
+    }
+
+    dynbfs->dist[dynbfs->root] = 0;
+    dynbfs->queue[0] = dynbfs->root;
+    head = 0;
+    tail = 1;
+
+    while (head < tail) {
+        u = dynbfs->queue[head++];
+        adj = &dynbfs->out[u];
+
+        for (i = 0; i < adj->size; i++) {
+            if (dynbfs->dist[adj->ids[i]] < 0) {
+                dynbfs->dist[adj->ids[i]] = dynbfs->dist[u] + 1;
+                dynbfs->pred[adj->ids[i]] = u;
+                dynbfs->queue[tail++] = adj->ids[i];
+            }
+        }
+    }
+}
+
+static void research(DynBfs* dynbfs) {
+    int* old;
+    int v;
+
+    /* Rerun the whole search, counting the hop counts it changes */
+    old = malloc(dynbfs->vcount * sizeof(int));
+    if (old) {
+        memcpy(old, dynbfs->dist, dynbfs->vcount * sizeof(int));
+    }
+
+    search(dynbfs);
+
+    dynbfs->changed = old ? 0 : dynbfs->vcount;
+    for (v = 0; old && v < dynbfs->vcount; v++) {
+        if (old[v] != dynbfs->dist[v]) {
+            dynbfs->changed += 1;
+        }
+    }
+
+    free(old);
+}
+
+static int compare_seeds(const void* key1, const void* key2) {
+    const DynSeed* s1 = key1;
+    const DynSeed* s2 = key2;
+
+    return (s1->dist > s2->dist) - (s1->dist < s2->dist);
+}
+
+int dynbfs_init(DynBfs* dynbfs, const CsrGraph* csr, int root, int limit) {
+    const int* adj;
+    int v, i;
+
+    if (root < 0 || root >= csr_vcount(csr)) {
+        return -1;
+    }
+
+    memset(dynbfs, 0, sizeof(DynBfs));
+    dynbfs->vcount = csr_vcount(csr);
+    dynbfs->root = root;
+    dynbfs->limit = limit > 0 ? limit : dynbfs->vcount / 4 + 1;
+
+    dynbfs->dist = malloc(dynbfs->vcount * sizeof(int));
+    dynbfs->pred = malloc(dynbfs->vcount * sizeof(int));
+    dynbfs->queue = malloc(dynbfs->vcount * sizeof(int));
+    dynbfs->mark = calloc(dynbfs->vcount, 1);
+    dynbfs->out = calloc(dynbfs->vcount, sizeof(DynAdj));
+    dynbfs->in = calloc(dynbfs->vcount, sizeof(DynAdj));
+    if (!dynbfs->dist || !dynbfs->pred || !dynbfs->queue || !dynbfs->mark || !dynbfs->out || !dynbfs->in) {
+        dynbfs_destroy(dynbfs);
+        return -1;
+    }
+
+    /* Copy the frozen graph into growable out- & in-neighbour arrays */
+    for (v = 0; v < dynbfs->vcount; v++) {
+        adj = csr_neighbours(csr, v);
+
+        for (i = 0; i < csr_degree(csr, v); i++) {
+            if (adj_append(&dynbfs->out[v], adj[i]) || adj_append(&dynbfs->in[adj[i]], v)) {
+                dynbfs_destroy(dynbfs);
+                return -1;
+            }
+        }
+    }
+
+    search(dynbfs);
+    return 0;
+}
+
+void dynbfs_destroy(DynBfs* dynbfs) {
+    int v;
+
+    for (v = 0; v < dynbfs->vcount; v++) {
+        if (dynbfs->out) {
+            free(dynbfs->out[v].ids);
+        }
+
+        if (dynbfs->in) {
+            free(dynbfs->in[v].ids);
+        }
+    }
+
+    free(dynbfs->dist);
+    free(dynbfs->pred);
+    free(dynbfs->queue);
+    free(dynbfs->mark);
+    free(dynbfs->out);
+    free(dynbfs->in);
+    memset(dynbfs, 0, sizeof(DynBfs));
+}
+
+int dynbfs_ins_edge(DynBfs* dynbfs, int id1, int id2) {
+    DynAdj* adj;
+    int head, tail, u, i;
+
+    if (id1 < 0 || id1 >= dynbfs->vcount || id2 < 0 || id2 >= dynbfs->vcount) {
+        return -1;
+    }
+
+    /* Don't allow insertion of an edge that is already in the graph */
+    for (i = 0; i < dynbfs->out[id1].size; i++) {
+        if (dynbfs->out[id1].ids[i] == id2) {
+            return 1;
+        }
+    }
+
+    if (adj_append(&dynbfs->out[id1], id2)) {
+        return -1;
+    }
+
+    if (adj_append(&dynbfs->in[id2], id1)) {
+        adj_remove(&dynbfs->out[id1], id2);
+        return -1;
+    }
+
+    dynbfs->changed = 0;
+
+    /* Nothing changes unless the new edge shortens the way to the 2nd vertex */
+    if (dynbfs->dist[id1] < 0 || (dynbfs->dist[id2] >= 0 && dynbfs->dist[id2] <= dynbfs->dist[id1] + 1)) {
+        return 0;
+    }
+
+    dynbfs->dist[id2] = dynbfs->dist[id1] + 1;
+    dynbfs->pred[id2] = id1;
+    dynbfs->queue[0] = id2;
+    head = 0;
+    tail = 1;
+
+    /* Propagate the decrease outward, visiting only vertices that improve */
+    while (head < tail) {
+        u = dynbfs->queue[head++];
+        adj = &dynbfs->out[u];
+        dynbfs->changed += 1;
+
+        for (i = 0; i < adj->size; i++) {
+            if (dynbfs->dist[adj->ids[i]] < 0 || dynbfs->dist[adj->ids[i]] > dynbfs->dist[u] + 1) {
+                dynbfs->dist[adj->ids[i]] = dynbfs->dist[u] + 1;
+                dynbfs->pred[adj->ids[i]] = u;
+                dynbfs->queue[tail++] = adj->ids[i];
+            }
+        }
+    }
+
+    return 0;
+}
+
+int dynbfs_rem_edge(DynBfs* dynbfs, int id1, int id2) {
+    DynSeed* seeds;
+    DynAdj* adj;
+    int count, head, tail, next, u, x, i;
+
+    if (id1 < 0 || id1 >= dynbfs->vcount || id2 < 0 || id2 >= dynbfs->vcount) {
+        return -1;
+    }
+
+    if (adj_remove(&dynbfs->out[id1], id2)) {
+        return -1;
+    }
+
+    adj_remove(&dynbfs->in[id2], id1);
+    dynbfs->changed = 0;
+
+    /* Only the subtree hanging off a removed tree edge can be affected */
+    if (dynbfs->pred[id2] != id1) {
+        return 0;
+    }
+
+    /* Prefer another predecessor at the same depth if there is one */
+    adj = &dynbfs->in[id2];
+    for (i = 0; i < adj->size; i++) {
+        if (dynbfs->dist[adj->ids[i]] == dynbfs->dist[id2] - 1) {
+            dynbfs->pred[id2] = adj->ids[i];
+            return 0;
+        }
+    }
+
+    /* Collect the affected subtree, giving up once it grows too large */
+    dynbfs->queue[0] = id2;
+    dynbfs->mark[id2] = 1;
+    count = 1;
+
+    for (head = 0; head < count; head++) {
+        u = dynbfs->queue[head];
+        adj = &dynbfs->out[u];
+
+        for (i = 0; i < adj->size; i++) {
+            x = adj->ids[i];
+            if (dynbfs->mark[x] || dynbfs->pred[x] != u) {
+                continue;
+            }
+
+            if (count >= dynbfs->limit) {
+                for (x = 0; x < count; x++) {
+                    dynbfs->mark[dynbfs->queue[x]] = 0;
+                }
+                research(dynbfs);
+                return 0;
+            }
+
+            dynbfs->mark[x] = 1;
+            dynbfs->queue[count++] = x;
+        }
+    }
+
+    seeds = malloc(count * sizeof(DynSeed));
+    if (!seeds) {
+        for (x = 0; x < count; x++) {
+            dynbfs->mark[dynbfs->queue[x]] = 0;
+        }
+        research(dynbfs);
+        return 0;
+    }
+
+    /* Seed each affected vertex from its best unaffected in-neighbour */
+    for (i = 0; i < count; i++) {
+        u = dynbfs->queue[i];
+        adj = &dynbfs->in[u];
+
+        seeds[i].id = u;
+        seeds[i].old = dynbfs->dist[u];
+        seeds[i].dist = INT_MAX;
+        dynbfs->pred[u] = -1;
+
+        for (x = 0; x < adj->size; x++) {
+            if (!dynbfs->mark[adj->ids[x]] && dynbfs->dist[adj->ids[x]] >= 0
+                && dynbfs->dist[adj->ids[x]] + 1 < seeds[i].dist) {
+                seeds[i].dist = dynbfs->dist[adj->ids[x]] + 1;
+                dynbfs->pred[u] = adj->ids[x];
+            }
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        dynbfs->dist[seeds[i].id] = seeds[i].dist == INT_MAX ? -1 : seeds[i].dist;
+    }
+
+    qsort(seeds, count, sizeof(DynSeed), compare_seeds);
+
+    /* Settle the subtree in hop order, merging the seeds with a FIFO queue */
+    next = head = tail = 0;
+    for (;;) {
+        if (next < count && seeds[next].dist != INT_MAX
+            && (head == tail || seeds[next].dist <= dynbfs->dist[dynbfs->queue[head]])) {
+            u = seeds[next++].id;
+            if (dynbfs->mark[u] != 1 || dynbfs->dist[u] != seeds[next - 1].dist) {
+                continue; /* already settled with a shorter hop count */
+            }
+        }
+        else if (head < tail) {
+            u = dynbfs->queue[head++];
+            if (dynbfs->mark[u] != 1) {
+                continue;
+            }
+        }
+        else {
+            break;
+        }
+
+        dynbfs->mark[u] = 2;
+        adj = &dynbfs->out[u];
+
+        for (i = 0; i < adj->size; i++) {
+            x = adj->ids[i];
+            if (dynbfs->mark[x] == 1 && (dynbfs->dist[x] < 0 || dynbfs->dist[x] > dynbfs->dist[u] + 1)) {
+                dynbfs->dist[x] = dynbfs->dist[u] + 1;
+                dynbfs->pred[x] = u;
+                dynbfs->queue[tail++] = x;
+            }
+        }
+    }
+
+    /* Count the hop counts that actually changed & clear the marks */
+    for (i = 0; i < count; i++) {
+        if (dynbfs->dist[seeds[i].id] != seeds[i].old) {
+            dynbfs->changed += 1;
+        }
+        dynbfs->mark[seeds[i].id] = 0;
+    }
+
+    free(seeds);
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <string.h>
+#include "../include/epoch.h"
+
+/* Retired objects to accumulate before trying to reclaim any */
+#define EPOCH_BATCH 64
+
+static void free_retired(EpochDomain* domain, EpochRetired** list) {
+    EpochRetired* retired;
+
+    while (*list != NULL) {
+        retired = *list;
+        *list = retired->next;
+        retired->destroy(retired->data);
+        free(retired);
+        domain->pending -= 1;
+    }
+}
+
+static void reclaim(EpochDomain* domain) {
+    EpochThread* thread;
+    unsigned long global, epoch;
+
+    /* Advance the global epoch once every active thread has observed it */
+    global = atomic_load(&domain->global);
+
+    for (thread = domain->threads; thread != NULL; thread = thread->next) {
+        epoch = atomic_load(&thread->epoch);
+        if (epoch != EPOCH_IDLE && epoch != global) {
+            break;
+        }
+    }
+
+    if (thread) {
+        return;
+    }
+
+    global += 1;
+    atomic_store(&domain->global, global);
+
+    /* Nothing can still see what was retired two epochs ago */
+    free_retired(domain, &domain->retired[(global + 1) % 3]);
+}
+
+int epoch_init(EpochDomain* domain) {
+    atomic_init(&domain->global, 0);
+    domain->threads = NULL;
+    domain->retired[0] = NULL;
+    domain->retired[1] = NULL;
+    domain->retired[2] = NULL;
+    domain->pending = 0;
+
+    return pthread_mutex_init(&domain->lock, NULL) ? -1 : 0;
+}
+
+void epoch_destroy(EpochDomain* domain) {
+    int i;
+
+    /* No readers remain, so everything retired can go */
+    for (i = 0; i < 3; i++) {
+        free_retired(domain, &domain->retired[i]);
+    }
+
+    pthread_mutex_destroy(&domain->lock);
+    memset(domain, 0, sizeof(EpochDomain));
+}
+
+void epoch_register(EpochDomain* domain, EpochThread* thread) {
+    atomic_init(&thread->epoch, EPOCH_IDLE);
+
+    pthread_mutex_lock(&domain->lock);
+    thread->next = domain->threads;
+    domain->threads = thread;
+    pthread_mutex_unlock(&domain->lock);
+}
+
+void epoch_unregister(EpochDomain* domain, EpochThread* thread) {
+    EpochThread** position;
+
+    pthread_mutex_lock(&domain->lock);
+
+    for (position = &domain->threads; *position != NULL; position = &(*position)->next) {
+        if (*position == thread) {
+            *position = thread->next;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&domain->lock);
+}
+
+void epoch_enter(EpochDomain* domain, EpochThread* thread) {
+    unsigned long global;
+
+    /* Announce the current epoch, retrying if it moved underneath us */
+    do {
+        global = atomic_load(&domain->global);
+        atomic_store(&thread->epoch, global);
+    } while (global != atomic_load(&domain->global));
+}
+
+void epoch_exit(EpochThread* thread) {
+    atomic_store_explicit(&thread->epoch, EPOCH_IDLE, memory_order_release);
+}
+
+int epoch_retire(EpochDomain* domain, void* data, void (*destroy)(void* data)) {
+    EpochRetired* retired;
+
+    retired = malloc(sizeof(EpochRetired));
+    if (!retired) {
+        return -1;
+    }
+
+    epoch_retire_record(domain, retired, data, destroy);
+    return 0;
+}
+
+void epoch_retire_record(EpochDomain* domain, EpochRetired* retired, void* data, void (*destroy)(void* data)) {
+    EpochRetired** list;
+
+    retired->data = data;
+    retired->destroy = destroy;
+
+    pthread_mutex_lock(&domain->lock);
+
+    /* The global epoch only moves while the lock is held */
+    list = &domain->retired[atomic_load(&domain->global) % 3];
+    retired->next = *list;
+    *list = retired;
+    domain->pending += 1;
+
+    if (domain->pending >= EPOCH_BATCH) {
+        reclaim(domain);
+    }
+
+    pthread_mutex_unlock(&domain->lock);
+}
+
+void epoch_reclaim(EpochDomain* domain) {
+    pthread_mutex_lock(&domain->lock);
+    reclaim(domain);
+    pthread_mutex_unlock(&domain->lock);
+}
@@ -0,0 +1,181 @@
+#include "../../include/vgraph.h"
+#include <stdio.h>
+#include <unistd.h>
+
+/**
+ * @brief Shared benchmark state
+ */
+typedef struct Bench_ {
+    VGraph* vgraph; /**< The graph under test */
+    atomic_int running; /**< Cleared to stop all threads */
+    atomic_long queries; /**< Searches completed by readers */
+    atomic_long updates; /**< Edge updates completed by the writer */
+} Bench;
+
+/**
+ * @brief Advance a simple linear congruential generator
+ *
+ * @param seed The generator state
+ * @return The next pseudo-random number.
+ */
+unsigned int next_random(unsigned int* seed);
+
+/**
+ * @brief Run searches on pinned snapshots until told to stop
+ *
+ * @param arg The shared benchmark state
+ * @return NULL
+ */
+void* reader(void* arg);
+
+/**
+ * @brief Insert & remove random edges until told to stop
+ *
+ * @param arg The shared benchmark state
+ * @return NULL
+ */
+void* writer(void* arg);
+
+/**
+ * @brief Build a random graph
+ *
+ * @param csr The frozen graph to build
+ * @param vcount The number of vertices
+ * @param ecount The number of edges
+ * @return 0 on success or -1 on failure.
+ */
+int build_random(CsrGraph* csr, int vcount, int ecount);
+
+int main(int argc, char* argv[]) {
+    pthread_t threads[64];
+    pthread_t writer_thread;
+    CsrGraph csr;
+    VGraph vgraph;
+    Bench bench;
+    int maxthreads, nthreads, i;
+
+    maxthreads = argc > 1 ? atoi(argv[1]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (maxthreads < 1 || maxthreads > 64) {
+        fputs("usage: concbfs [threads]\n", stderr);
+        return 1;
+    }
+
+    if (build_random(&csr, 100000, 1000000) || vgraph_init(&vgraph, &csr)) {
+        fputs("Error building graph!\n", stderr);
+        return 1;
+    }
+
+    csr_destroy(&csr);
+
+    bench.vgraph = &vgraph;
+    printf("%8s %14s %14s\n", "readers", "searches/s", "updates/s");
+
+    for (nthreads = 1; nthreads <= maxthreads; nthreads = nthreads < maxthreads && nthreads * 2 > maxthreads ? maxthreads : nthreads * 2) {
+        atomic_init(&bench.running, 1);
+        atomic_init(&bench.queries, 0);
+        atomic_init(&bench.updates, 0);
+
+        pthread_create(&writer_thread, NULL, writer, &bench);
+        for (i = 0; i < nthreads; i++) {
+            pthread_create(&threads[i], NULL, reader, &bench);
+        }
+
+        sleep(1);
+        atomic_store(&bench.running, 0);
+
+        for (i = 0; i < nthreads; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        pthread_join(writer_thread, NULL);
+
+        printf("%8d %14ld %14ld\n", nthreads, atomic_load(&bench.queries), atomic_load(&bench.updates));
+    }
+
+    vgraph_destroy(&vgraph);
+    return 0;
+}
+
+unsigned int next_random(unsigned int* seed) {
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+void* reader(void* arg) {
+    Bench* bench = arg;
+    const VGraphVersion* version;
+    EpochThread self;
+    int* hops;
+    unsigned int seed;
+    long count;
+
+    seed = (unsigned int) (size_t) &self;
+    count = 0;
+    hops = NULL;
+
+    vgraph_attach(bench->vgraph, &self);
+
+    while (atomic_load_explicit(&bench->running, memory_order_relaxed)) {
+        version = vgraph_pin(bench->vgraph, &self);
+
+        hops = realloc(hops, vgraph_vcount(version) * sizeof(int));
+        if (!hops || vgraph_bfs(version, next_random(&seed) % vgraph_vcount(version), hops)) {
+            vgraph_unpin(&self);
+            break;
+        }
+
+        vgraph_unpin(&self);
+        count++;
+    }
+
+    vgraph_detach(bench->vgraph, &self);
+    free(hops);
+
+    atomic_fetch_add(&bench->queries, count);
+    return NULL;
+}
+
+void* writer(void* arg) {
+    Bench* bench = arg;
+    unsigned int seed;
+    long count;
+    int vcount, id1, id2;
+
+    seed = 42;
+    count = 0;
+    vcount = vgraph_vcount(atomic_load(&bench->vgraph->current));
+
+    while (atomic_load_explicit(&bench->running, memory_order_relaxed)) {
+        id1 = next_random(&seed) % vcount;
+        id2 = next_random(&seed) % vcount;
+
+        /* Toggle the edge so the graph keeps roughly the same size */
+        if (vgraph_ins_edge(bench->vgraph, id1, id2) == 1) {
+            vgraph_rem_edge(bench->vgraph, id1, id2);
+        }
+
+        count++;
+    }
+
+    atomic_fetch_add(&bench->updates, count);
+    return NULL;
+}
+
+int build_random(CsrGraph* csr, int vcount, int ecount) {
+    unsigned int seed;
+    int* edges;
+    int e, rc;
+
+    edges = malloc(2 * (size_t) ecount * sizeof(int));
+    if (!edges) {
+        return -1;
+    }
+
+    seed = 7;
+    for (e = 0; e < 2 * ecount; e++) {
+        edges[e] = next_random(&seed) % vcount;
+    }
+
+    rc = csr_from_edges(csr, vcount, edges, ecount);
+    free(edges);
+    return rc;
+}
@@ -0,0 +1,171 @@
+#include "../../include/bfs.h"
+#include "../../include/pbfs.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Build a skewed random graph with the R-MAT generator
+ *
+ * @param csr The frozen graph to build
+ * @param scale The graph has 2^scale vertices
+ * @param edgefactor The average out-degree
+ * @return 0 on success or -1 on failure.
+ */
+int build_rmat(CsrGraph* csr, int scale, int edgefactor);
+
+/**
+ * @brief Search a graph split across worker processes & report its traffic
+ *
+ * @param csr The graph to search
+ * @param nparts The number of partitions
+ * @param partition How vertices are dealt out to partitions
+ * @param expected The hop counts of a single-process search
+ * @param verbose Whether to print the traffic of each level
+ * @return 0 on success or -1 on failure.
+ */
+int measure(const CsrGraph* csr, int nparts, PbfsPartition partition, const int* expected, int verbose);
+
+int main(int argc, char* argv[]) {
+    CsrGraph csr;
+    int* expected;
+    int scale, maxparts, nparts;
+
+    scale = argc > 1 ? atoi(argv[1]) : 18;
+    maxparts = argc > 2 ? atoi(argv[2]) : 8;
+    if (scale < 1 || scale > 26 || maxparts < 1 || maxparts > PBFS_MAX_PARTS) {
+        fputs("usage: dbfs [scale] [partitions]\n", stderr);
+        return 1;
+    }
+
+    if (build_rmat(&csr, scale, 16)) {
+        fputs("Error building graph!\n", stderr);
+        return 1;
+    }
+
+    expected = malloc(csr_vcount(&csr) * sizeof(int));
+    if (!expected || bfs_csr(&csr, 0, expected)) {
+        fputs("Error searching graph!\n", stderr);
+        return 1;
+    }
+
+    printf("%d vertices, %d edges\n", csr_vcount(&csr), csr_ecount(&csr));
+    printf("%-6s %6s %7s %10s %12s %10s %10s\n", "scheme", "parts", "levels", "time (ms)", "messages", "MiB", "remote %");
+
+    for (nparts = 1; nparts <= maxparts; nparts = nparts < maxparts && nparts * 2 > maxparts ? maxparts : nparts * 2) {
+        if (measure(&csr, nparts, PBFS_RANGE, expected, 0) || measure(&csr, nparts, PBFS_HASH, expected, 0)) {
+            fputs("pbfs encountered an error, exiting...\n", stderr);
+            return 1;
+        }
+    }
+
+    /* Show how the traffic of the largest split is spread over the levels */
+    printf("\nper level, %d hashed partitions\n", maxparts);
+    if (measure(&csr, maxparts, PBFS_HASH, expected, 1)) {
+        fputs("pbfs encountered an error, exiting...\n", stderr);
+        return 1;
+    }
+
+    free(expected);
+    csr_destroy(&csr);
+
+    return 0;
+}
+
+int build_rmat(CsrGraph* csr, int scale, int edgefactor) {
+    unsigned long long seed;
+    double r;
+    int* edges;
+    int ecount, e, bit, u, v, rc;
+
+    ecount = edgefactor << scale;
+    edges = malloc(2 * (size_t) ecount * sizeof(int));
+    if (!edges) {
+        return -1;
+    }
+
+    /* Recursively pick a quadrant of the adjacency matrix for each edge */
+    seed = 88172645463325252ULL;
+    for (e = 0; e < ecount; e++) {
+        u = v = 0;
+
+        for (bit = 0; bit < scale; bit++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            r = (seed >> 11) * (1.0 / 9007199254740992.0);
+
+            if (r < 0.57) {
+                continue;
+            }
+            else if (r < 0.76) {
+                v |= 1 << bit;
+            }
+            else if (r < 0.95) {
+                u |= 1 << bit;
+            }
+            else {
+                u |= 1 << bit;
+                v |= 1 << bit;
+            }
+        }
+
+        edges[2 * e] = u;
+        edges[2 * e + 1] = v;
+    }
+
+    rc = csr_from_edges(csr, 1 << scale, edges, ecount);
+    free(edges);
+    return rc;
+}
+
+int measure(const CsrGraph* csr, int nparts, PbfsPartition partition, const int* expected, int verbose) {
+    struct timespec begin, end;
+    PbfsStats stats;
+    long messages, bytes, edges;
+    int* hops;
+    int level;
+
+    hops = malloc(csr_vcount(csr) * sizeof(int));
+    if (!hops) {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    if (pbfs(csr, 0, nparts, partition, hops, &stats)) {
+        free(hops);
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    /* Splitting the graph must not change a single hop count */
+    if (memcmp(hops, expected, csr_vcount(csr) * sizeof(int))) {
+        fputs("hop counts differ from a single-process search!\n", stderr);
+        pbfs_stats_destroy(&stats);
+        free(hops);
+        return -1;
+    }
+
+    messages = bytes = edges = 0;
+    for (level = 0; level < stats.nlevels; level++) {
+        messages += stats.levels[level].messages;
+        bytes += stats.levels[level].bytes;
+        edges += stats.levels[level].edges;
+
+        if (verbose) {
+            printf("level %2d: %9ld frontier %10ld edges %9ld messages %10ld bytes\n", level,
+                   stats.levels[level].frontier, stats.levels[level].edges,
+                   stats.levels[level].messages, stats.levels[level].bytes);
+        }
+    }
+
+    if (!verbose) {
+        printf("%-6s %6d %7d %10.1f %12ld %10.2f %10.1f\n", partition == PBFS_RANGE ? "range" : "hash",
+               nparts, stats.nlevels, (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6,
+               messages, bytes / 1048576.0, edges ? 100.0 * messages / edges : 0.0);
+    }
+
+    pbfs_stats_destroy(&stats);
+    free(hops);
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include "../../include/bfs.h"
+#include "../../include/dynbfs.h"
+#include <stdio.h>
+#include <time.h>
+
+/* Edge updates applied between checks against a fresh search */
+#define CHECK_EVERY 1000
+
+/**
+ * @brief Advance a simple linear congruential generator
+ *
+ * @param seed The generator state
+ * @return The next pseudo-random number.
+ */
+unsigned int next_random(unsigned int* seed);
+
+/**
+ * @brief Build a random graph
+ *
+ * @param csr The frozen graph to build
+ * @param vcount The number of vertices
+ * @param ecount The number of edges
+ * @return 0 on success or -1 on failure.
+ */
+int build_random(CsrGraph* csr, int vcount, int ecount);
+
+/**
+ * @brief Compare the maintained hop counts with a search of the current graph
+ *
+ * @param dynbfs The incrementally maintained search
+ * @param hops Scratch space for one hop count per vertex
+ * @param seconds Incremented by the time taken to search from scratch
+ * @return The number of vertices whose hop counts disagree, or -1 on failure.
+ */
+int check(const DynBfs* dynbfs, int* hops, double* seconds);
+
+/**
+ * @brief Measure the seconds between two points in time
+ *
+ * @param begin The earlier point
+ * @param end The later point
+ * @return The elapsed seconds.
+ */
+double elapsed(const struct timespec* begin, const struct timespec* end);
+
+int main(int argc, char* argv[]) {
+    struct timespec begin, end;
+    CsrGraph csr;
+    DynBfs dynbfs;
+    int* hops;
+    unsigned int seed;
+    double update_s, search_s;
+    long changed;
+    int updates, checks, wrong, rc, id1, id2, i;
+
+    updates = argc > 1 ? atoi(argv[1]) : 100000;
+    if (updates < 1) {
+        fputs("usage: dynhops [updates]\n", stderr);
+        return 1;
+    }
+
+    if (build_random(&csr, 100000, 400000) || dynbfs_init(&dynbfs, &csr, 0, 0)) {
+        fputs("Error building graph!\n", stderr);
+        return 1;
+    }
+
+    hops = malloc(csr_vcount(&csr) * sizeof(int));
+    if (!hops) {
+        fputs("Error allocating memory!\n", stderr);
+        return 1;
+    }
+
+    csr_destroy(&csr);
+
+    seed = 42;
+    update_s = search_s = 0.0;
+    changed = 0;
+    checks = wrong = 0;
+
+    for (i = 1; i <= updates; i++) {
+        id1 = next_random(&seed) % dynbfs.vcount;
+        id2 = next_random(&seed) % dynbfs.vcount;
+
+        /* Toggle the edge so the graph keeps roughly the same size */
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        rc = dynbfs_ins_edge(&dynbfs, id1, id2);
+        if (rc == 1) {
+            rc = dynbfs_rem_edge(&dynbfs, id1, id2);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (rc) {
+            fputs("dynbfs encountered an error, exiting...\n", stderr);
+            return 1;
+        }
+
+        update_s += elapsed(&begin, &end);
+        changed += dynbfs_changed(&dynbfs);
+
+        if (i % CHECK_EVERY == 0 || i == updates) {
+            rc = check(&dynbfs, hops, &search_s);
+            if (rc < 0) {
+                fputs("Error checking hop counts!\n", stderr);
+                return 1;
+            }
+
+            wrong += rc;
+            checks += 1;
+        }
+    }
+
+    printf("%d updates, %.1f hop counts changed per update\n", updates, (double) changed / updates);
+    printf("%-12s %14s\n", "method", "us/update");
+    printf("%-12s %14.2f\n", "incremental", update_s * 1e6 / updates);
+    printf("%-12s %14.2f\n", "recompute", search_s * 1e6 / checks);
+    printf("%d checks against bfs_csr, %d hop counts wrong\n", checks, wrong);
+
+    free(hops);
+    dynbfs_destroy(&dynbfs);
+
+    return wrong ? 1 : 0;
+}
+
+unsigned int next_random(unsigned int* seed) {
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+int build_random(CsrGraph* csr, int vcount, int ecount) {
+    unsigned int seed;
+    int* edges;
+    int e, rc;
+
+    edges = malloc(2 * (size_t) ecount * sizeof(int));
+    if (!edges) {
+        return -1;
+    }
+
+    seed = 7;
+    for (e = 0; e < 2 * ecount; e++) {
+        edges[e] = next_random(&seed) % vcount;
+    }
+
+    rc = csr_from_edges(csr, vcount, edges, ecount);
+    free(edges);
+    return rc;
+}
+
+int check(const DynBfs* dynbfs, int* hops, double* seconds) {
+    struct timespec begin, end;
+    CsrGraph csr;
+    int* edges;
+    int ecount, wrong, u, v, i;
+
+    ecount = 0;
+    for (u = 0; u < dynbfs->vcount; u++) {
+        ecount += dynbfs->out[u].size;
+    }
+
+    edges = malloc(2 * (size_t) (ecount ? ecount : 1) * sizeof(int));
+    if (!edges) {
+        return -1;
+    }
+
+    /* Freeze the graph as it stands after all updates so far */
+    ecount = 0;
+    for (u = 0; u < dynbfs->vcount; u++) {
+        for (i = 0; i < dynbfs->out[u].size; i++) {
+            edges[2 * ecount] = u;
+            edges[2 * ecount + 1] = dynbfs->out[u].ids[i];
+            ecount++;
+        }
+    }
+
+    if (csr_from_edges(&csr, dynbfs->vcount, edges, ecount)) {
+        free(edges);
+        return -1;
+    }
+
+    free(edges);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    if (bfs_csr(&csr, dynbfs->root, hops)) {
+        csr_destroy(&csr);
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *seconds += elapsed(&begin, &end);
+    csr_destroy(&csr);
+
+    wrong = 0;
+    for (v = 0; v < dynbfs->vcount; v++) {
+        wrong += dynbfs_dist(dynbfs, v) != hops[v];
+    }
+
+    return wrong;
+}
+
+double elapsed(const struct timespec* begin, const struct timespec* end) {
+    return (end->tv_sec - begin->tv_sec) + (end->tv_nsec - begin->tv_nsec) / 1e9;
+}
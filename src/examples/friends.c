@@ -0,0 +1,97 @@
+#include "../../include/centrality.h"
+#include "../../include/triangle.h"
+#include <stdio.h>
+#include <string.h>
+
+void befriend(Graph* graph, const char* name1, const char* name2) {
+    graph_ins_edge(graph, name1, name2);
+    graph_ins_edge(graph, name2, name1);
+}
+
+void build_graph(Graph* graph) {
+    /*
+           ("alice")-----("bob")
+             |    \      /   |
+             |     \    /    |
+             |    ("carol")  |
+             |     /    \    |
+             |    /      \   |
+           ("dave")-----("erin")-----("frank")
+     */
+    static const char* names[] = { "alice", "bob", "carol", "dave", "erin", "frank" };
+    int i;
+
+    for (i = 0; i < 6; i++) {
+        graph_ins_vertex(graph, names[i]);
+    }
+
+    befriend(graph, "alice", "bob");
+    befriend(graph, "alice", "carol");
+    befriend(graph, "alice", "dave");
+    befriend(graph, "bob", "carol");
+    befriend(graph, "bob", "erin");
+    befriend(graph, "carol", "dave");
+    befriend(graph, "carol", "erin");
+    befriend(graph, "dave", "erin");
+    befriend(graph, "erin", "frank");
+}
+
+int match_names(const void* name1, const void* name2) {
+    return strcmp(name1, name2) == 0;
+}
+
+int main(void) {
+    Graph graph;
+    CsrGraph csr;
+    long triangles[6];
+    double centrality[6];
+    int common[6];
+    long total;
+    int alice, erin, count, i;
+
+    graph_init(&graph, match_names, NULL);
+    build_graph(&graph);
+
+    if (csr_build(&csr, &graph)) {
+        fputs("Error freezing graph!\n", stderr);
+        return 1;
+    }
+
+    alice = csr_vertex_id(&csr, "alice");
+    erin = csr_vertex_id(&csr, "erin");
+
+    count = csr_common_neighbours(&csr, alice, erin, common);
+    printf("alice & erin have %d friends in common:", count);
+    for (i = 0; i < count; i++) {
+        printf(" %s", (const char*) csr_vertex(&csr, common[i]));
+    }
+    puts("");
+
+    /* Friendships go both ways, so each triangle is a circle of three friends */
+    total = triangle_count(&csr, 0, triangles);
+    if (total < 0) {
+        fputs("triangle_count encountered an error, exiting...\n", stderr);
+        return 1;
+    }
+
+    printf("%ld circles of three friends\n", total);
+    for (i = 0; i < csr_vcount(&csr); i++) {
+        printf("%s is in %ld\n", (const char*) csr_vertex(&csr, i), triangles[i]);
+    }
+
+    if (betweenness(&csr, 0, 0, 0, centrality)) {
+        fputs("betweenness encountered an error, exiting...\n", stderr);
+        return 1;
+    }
+
+    /* Each undirected shortest path is counted once in each direction */
+    puts("betweenness centrality");
+    for (i = 0; i < csr_vcount(&csr); i++) {
+        printf("%s = %.2f\n", (const char*) csr_vertex(&csr, i), centrality[i] / 2);
+    }
+
+    csr_destroy(&csr);
+    graph_destroy(&graph);
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "../../include/bistree.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Number of lookups timed at each size */
+#define LOOKUPS 1000000
+
+/**
+ * @brief Order two integers stored directly in data pointers
+ *
+ * @param key1 The first integer
+ * @param key2 The second integer
+ * @return -1, 0 or 1 as the first is less than, equal to or greater than the second.
+ */
+int compare_ints(const void* key1, const void* key2);
+
+/**
+ * @brief Time lookups in a tree, in batches & in its frozen snapshot
+ *
+ * @param count The number of entries
+ * @return 0 on success or -1 on failure.
+ */
+int measure(int count);
+
+int main(int argc, char* argv[]) {
+    int maxlog2, log2n;
+
+    maxlog2 = argc > 1 ? atoi(argv[1]) : 22;
+    if (maxlog2 < 10 || maxlog2 > 26) {
+        fputs("usage: frozen [log2 of largest size]\n", stderr);
+        return 1;
+    }
+
+    /* From a few KiB that fit in L1 to far more than any last-level cache */
+    printf("%10s %12s %14s %14s %14s\n", "entries", "KiB", "bistree (ns)", "batch (ns)", "frozen (ns)");
+    for (log2n = 10; log2n <= maxlog2; log2n += 2) {
+        if (measure(1 << log2n)) {
+            fputs("Error building tree!\n", stderr);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int compare_ints(const void* key1, const void* key2) {
+    intptr_t k1 = (intptr_t) key1;
+    intptr_t k2 = (intptr_t) key2;
+
+    return (k1 > k2) - (k1 < k2);
+}
+
+int measure(int count) {
+    struct timespec begin, end;
+    BisTree tree;
+    BisFrozen frozen;
+    void** items;
+    void** probes;
+    void** results;
+    void* data;
+    unsigned int seed;
+    double tree_ns, batch_ns, frozen_ns;
+    long found, batched;
+    int i;
+
+    items = malloc(count * sizeof(void*));
+    probes = malloc(LOOKUPS * sizeof(void*));
+    results = malloc(LOOKUPS * sizeof(void*));
+    if (!items || !probes || !results) {
+        free(items);
+        free(probes);
+        free(results);
+        return -1;
+    }
+
+    /* Even keys are in the tree, so a quarter of the probes miss */
+    for (i = 0; i < count; i++) {
+        items[i] = (void*) (intptr_t) (2 * i);
+    }
+
+    seed = 1;
+    for (i = 0; i < LOOKUPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        probes[i] = (void*) (intptr_t) ((seed >> 8) % count * 2 + ((seed >> 4) % 4 == 0));
+    }
+
+    bistree_init(&tree, compare_ints, NULL);
+    if (bistree_build_sorted(&tree, items, count) || bistree_freeze(&tree, &frozen)) {
+        bistree_destroy(&tree);
+        free(items);
+        free(probes);
+        free(results);
+        return -1;
+    }
+
+    found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < LOOKUPS; i++) {
+        data = probes[i];
+        found += !bistree_lookup(&tree, &data);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    tree_ns = ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / LOOKUPS;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    batched = bistree_lookup_batch(&tree, probes, LOOKUPS, results);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    batch_ns = ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / LOOKUPS;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < LOOKUPS; i++) {
+        data = probes[i];
+        found -= !bistree_frozen_lookup(&frozen, &data);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    frozen_ns = ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / LOOKUPS;
+
+    /* All three must find exactly the same entries */
+    for (i = 0; i < LOOKUPS; i++) {
+        batched -= results[i] == probes[i];
+    }
+
+    if (found || batched) {
+        fputs("batched or frozen lookups disagree with the tree!\n", stderr);
+    }
+
+    printf("%10d %12.0f %14.1f %14.1f %14.1f\n", count, count * sizeof(void*) / 1024.0, tree_ns, batch_ns,
+           frozen_ns);
+
+    bistree_frozen_destroy(&frozen);
+    bistree_destroy(&tree);
+    free(items);
+    free(probes);
+    free(results);
+    return 0;
+}
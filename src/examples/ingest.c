@@ -0,0 +1,183 @@
+#include "../../include/bistree.h"
+#include "../../include/skiplist.h"
+#include <stdio.h>
+#include <unistd.h>
+
+/* Keys live in 0..KEYS-1 */
+#define KEYS 1000000
+
+/**
+ * @brief Shared benchmark state
+ */
+typedef struct Bench_ {
+    SkipList* list; /**< The lock-free map, or NULL to lock the tree */
+    BisTree* tree; /**< The tree, guarded by lock */
+    pthread_mutex_t lock; /**< Guards the tree */
+    atomic_int running; /**< Cleared to stop all threads */
+    atomic_long ops; /**< Operations completed by all threads */
+} Bench;
+
+/**
+ * @brief Advance a simple linear congruential generator
+ *
+ * @param seed The generator state
+ * @return The next pseudo-random number.
+ */
+unsigned int next_random(unsigned int* seed);
+
+/**
+ * @brief Compare two keys stored directly in the data pointers
+ *
+ * @param key1 The first key
+ * @param key2 The second key
+ * @return 1 if key1 > key2, -1 if key1 < key2, 0 if equal.
+ */
+int compare_keys(const void* key1, const void* key2);
+
+/**
+ * @brief Insert, remove & look up random keys until told to stop
+ *
+ * @param arg The shared benchmark state
+ * @return NULL
+ */
+void* worker(void* arg);
+
+/**
+ * @brief Run one round of workers & report their throughput
+ *
+ * @param bench The shared benchmark state
+ * @param nthreads The number of worker threads
+ */
+void measure(Bench* bench, int nthreads);
+
+int main(int argc, char* argv[]) {
+    BisTree tree;
+    SkipList list;
+    Bench bench;
+    int maxthreads, nthreads;
+
+    maxthreads = argc > 1 ? atoi(argv[1]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (maxthreads < 1 || maxthreads > 64) {
+        fputs("usage: ingest [threads]\n", stderr);
+        return 1;
+    }
+
+    bistree_init(&tree, compare_keys, NULL);
+    if (skiplist_init(&list, compare_keys, NULL)) {
+        fputs("Error building list!\n", stderr);
+        return 1;
+    }
+
+    bench.tree = &tree;
+    pthread_mutex_init(&bench.lock, NULL);
+    printf("%-10s %8s %14s %10s\n", "map", "threads", "ops/s", "entries");
+
+    /* Both maps keep whatever the previous rounds left in them */
+    for (nthreads = 1; nthreads <= maxthreads; nthreads = nthreads < maxthreads && nthreads * 2 > maxthreads ? maxthreads : nthreads * 2) {
+        bench.list = NULL;
+        measure(&bench, nthreads);
+
+        bench.list = &list;
+        measure(&bench, nthreads);
+    }
+
+    pthread_mutex_destroy(&bench.lock);
+    skiplist_destroy(&list);
+    bistree_destroy(&tree);
+    return 0;
+}
+
+unsigned int next_random(unsigned int* seed) {
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+int compare_keys(const void* key1, const void* key2) {
+    intptr_t k1 = (intptr_t) key1;
+    intptr_t k2 = (intptr_t) key2;
+
+    return k1 > k2 ? 1 : k1 < k2 ? -1 : 0;
+}
+
+void* worker(void* arg) {
+    Bench* bench = arg;
+    EpochThread self;
+    unsigned int seed, r;
+    void* data;
+    long count;
+
+    seed = (unsigned int) (size_t) &self;
+    count = 0;
+
+    if (bench->list) {
+        skiplist_attach(bench->list, &self);
+    }
+
+    /* Half inserts, a quarter removes & a quarter lookups */
+    while (atomic_load_explicit(&bench->running, memory_order_relaxed)) {
+        r = next_random(&seed);
+        data = (void*) (intptr_t) (r % KEYS);
+
+        if (bench->list) {
+            if (r >> 22 < 2) {
+                skiplist_insert(bench->list, &self, data);
+            }
+            else if (r >> 22 == 2) {
+                skiplist_remove(bench->list, &self, data);
+            }
+            else {
+                skiplist_lookup(bench->list, &self, &data);
+            }
+        }
+        else {
+            pthread_mutex_lock(&bench->lock);
+            if (r >> 22 < 2) {
+                bistree_insert(bench->tree, data);
+            }
+            else if (r >> 22 == 2) {
+                bistree_remove(bench->tree, data);
+            }
+            else {
+                bistree_lookup(bench->tree, &data);
+            }
+            pthread_mutex_unlock(&bench->lock);
+        }
+
+        count++;
+    }
+
+    if (bench->list) {
+        skiplist_detach(bench->list, &self);
+    }
+
+    atomic_fetch_add(&bench->ops, count);
+    return NULL;
+}
+
+void measure(Bench* bench, int nthreads) {
+    pthread_t threads[64];
+    BisTreeStats stats;
+    int i;
+
+    atomic_init(&bench->running, 1);
+    atomic_init(&bench->ops, 0);
+
+    for (i = 0; i < nthreads; i++) {
+        pthread_create(&threads[i], NULL, worker, bench);
+    }
+
+    sleep(1);
+    atomic_store(&bench->running, 0);
+
+    for (i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (bench->list) {
+        printf("%-10s %8d %14ld %10d\n", "skiplist", nthreads, atomic_load(&bench->ops), skiplist_size(bench->list));
+    }
+    else {
+        bistree_stats(bench->tree, &stats);
+        printf("%-10s %8d %14ld %10d\n", "bistree", nthreads, atomic_load(&bench->ops), stats.live);
+    }
+}
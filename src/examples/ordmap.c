@@ -0,0 +1,266 @@
+#include "../../include/bistree.h"
+#include "../../include/bptree.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Number of lookups timed for each map */
+#define LOOKUPS 2000000
+
+/**
+ * @brief Order two integers stored directly in data pointers
+ *
+ * @param key1 The first integer
+ * @param key2 The second integer
+ * @return -1, 0 or 1 as the first is less than, equal to or greater than the second.
+ */
+int compare_ints(const void* key1, const void* key2);
+
+/**
+ * @brief Order two integers held in allocated memory
+ *
+ * @param key1 The first integer
+ * @param key2 The second integer
+ * @return -1, 0 or 1 as the first is less than, equal to or greater than the second.
+ */
+int compare_boxed(const void* key1, const void* key2);
+
+/**
+ * @brief Fill a B+tree with allocated integers, then remove & free most of them
+ *
+ * @param keys The integers in insertion order, reused in reverse as the removal order
+ * @param n The number of integers
+ * @return The number of entries left that are wrong or missing, or -1 on failure.
+ */
+int churn(void* const* keys, int n);
+
+/**
+ * @brief Pull out the integer stored in a data pointer
+ *
+ * @param data The data
+ * @return The integer key.
+ */
+int int_key(const void* data);
+
+/**
+ * @brief Seconds elapsed since a moment
+ *
+ * @param begin The moment
+ * @return The seconds elapsed.
+ */
+double elapsed(const struct timespec* begin);
+
+int main(int argc, char* argv[]) {
+    struct timespec begin;
+    BisTree avl;
+    BpTree generic;
+    BpTree integer;
+    BpCursor cursor;
+    void** keys;
+    void** probes;
+    void* data;
+    unsigned int seed;
+    double build[3], lookup[3];
+    long found[3];
+    int n, i, j;
+
+    n = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (n < 1) {
+        fputs("usage: ordmap [entries]\n", stderr);
+        return 1;
+    }
+
+    keys = malloc(n * sizeof(void*));
+    probes = malloc(LOOKUPS * sizeof(void*));
+    if (!keys || !probes) {
+        fputs("Error allocating memory!\n", stderr);
+        return 1;
+    }
+
+    /* Insert the keys in a random order, then look them up in another */
+    seed = 1;
+    for (i = 0; i < n; i++) {
+        keys[i] = (void*) (intptr_t) (2 * i);
+    }
+
+    for (i = n - 1; i > 0; i--) {
+        seed = seed * 1103515245 + 12345;
+        j = (seed >> 8) % (i + 1);
+        data = keys[i];
+        keys[i] = keys[j];
+        keys[j] = data;
+    }
+
+    for (i = 0; i < LOOKUPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        probes[i] = keys[(seed >> 8) % n];
+    }
+
+    bistree_init(&avl, compare_ints, NULL);
+    bptree_init(&generic, compare_ints, NULL);
+    bptree_init_int(&integer, int_key, NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < n; i++) {
+        bistree_insert(&avl, keys[i]);
+    }
+    build[0] = elapsed(&begin);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < n; i++) {
+        bptree_insert(&generic, keys[i]);
+    }
+    build[1] = elapsed(&begin);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < n; i++) {
+        bptree_insert(&integer, keys[i]);
+    }
+    build[2] = elapsed(&begin);
+
+    found[0] = found[1] = found[2] = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < LOOKUPS; i++) {
+        data = probes[i];
+        found[0] += !bistree_lookup(&avl, &data);
+    }
+    lookup[0] = elapsed(&begin);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < LOOKUPS; i++) {
+        data = probes[i];
+        found[1] += !bptree_lookup(&generic, &data);
+    }
+    lookup[1] = elapsed(&begin);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < LOOKUPS; i++) {
+        data = probes[i];
+        found[2] += !bptree_lookup(&integer, &data);
+    }
+    lookup[2] = elapsed(&begin);
+
+    printf("%d entries, %d lookups\n", n, LOOKUPS);
+    printf("%-16s %12s %14s %8s\n", "map", "build (ms)", "lookup (ns)", "found");
+    printf("%-16s %12.1f %14.1f %8ld\n", "bistree", build[0] * 1e3, lookup[0] * 1e9 / LOOKUPS, found[0]);
+    printf("%-16s %12.1f %14.1f %8ld\n", "bptree compare", build[1] * 1e3, lookup[1] * 1e9 / LOOKUPS, found[1]);
+    printf("%-16s %12.1f %14.1f %8ld\n", "bptree int keys", build[2] * 1e3, lookup[2] * 1e9 / LOOKUPS, found[2]);
+
+    /* Scan the middle half along the chain of leaves */
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    data = (void*) (intptr_t) (n / 2);
+    bptree_seek(&integer, &cursor, data);
+    for (i = 0; i < n / 2 && !bptree_next(&cursor, &data); i++) {
+        ;
+    }
+
+    printf("scanned %d entries from key %d in %.1f ms\n", i, n / 2, elapsed(&begin) * 1e3);
+
+    /* Removals free their data, so a separator left pointing at it would be caught */
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    j = churn(keys, n);
+    if (j) {
+        fputs(j < 0 ? "Error allocating memory!\n" : "bptree lost track of entries while removing!\n", stderr);
+        return 1;
+    }
+
+    printf("inserted, removed & freed %d entries in %.1f ms\n", n, elapsed(&begin) * 1e3);
+
+    bistree_destroy(&avl);
+    bptree_destroy(&generic);
+    bptree_destroy(&integer);
+    free(keys);
+    free(probes);
+
+    return 0;
+}
+
+int compare_ints(const void* key1, const void* key2) {
+    intptr_t k1 = (intptr_t) key1;
+    intptr_t k2 = (intptr_t) key2;
+
+    return (k1 > k2) - (k1 < k2);
+}
+
+int compare_boxed(const void* key1, const void* key2) {
+    int k1 = *(const int*) key1;
+    int k2 = *(const int*) key2;
+
+    return (k1 > k2) - (k1 < k2);
+}
+
+int churn(void* const* keys, int n) {
+    BpTree tree;
+    BpCursor cursor;
+    void* data;
+    int* box;
+    int key, wrong, prev, count, i;
+
+    bptree_init(&tree, compare_boxed, free);
+
+    for (i = 0; i < n; i++) {
+        box = malloc(sizeof(int));
+        if (!box) {
+            bptree_destroy(&tree);
+            return -1;
+        }
+
+        *box = (int) (intptr_t) keys[i];
+        if (bptree_insert(&tree, box) < 0) {
+            free(box);
+            bptree_destroy(&tree);
+            return -1;
+        }
+    }
+
+    /* Remove all but every 8th key, freeing each as the caller owns it again */
+    wrong = 0;
+    for (i = n - 1; i >= 0; i--) {
+        if (i % 8 == 0) {
+            continue;
+        }
+
+        key = (int) (intptr_t) keys[i];
+        data = &key;
+        if (bptree_remove(&tree, &data)) {
+            wrong++;
+            continue;
+        }
+
+        wrong += *(int*) data != key;
+        free(data);
+    }
+
+    /* What's left must still be found, in order, & nothing else */
+    for (i = 0; i < n; i++) {
+        key = (int) (intptr_t) keys[i];
+        data = &key;
+        wrong += !bptree_lookup(&tree, &data) != (i % 8 == 0);
+    }
+
+    count = 0;
+    prev = -1;
+    bptree_seek(&tree, &cursor, NULL);
+    while (!bptree_next(&cursor, &data)) {
+        wrong += *(int*) data <= prev;
+        prev = *(int*) data;
+        count++;
+    }
+
+    wrong += count != bptree_size(&tree) || count != (n + 7) / 8;
+
+    bptree_destroy(&tree);
+    return wrong;
+}
+
+int int_key(const void* data) {
+    return (int) (intptr_t) data;
+}
+
+double elapsed(const struct timespec* begin) {
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - begin->tv_sec) + (end.tv_nsec - begin->tv_nsec) / 1e9;
+}
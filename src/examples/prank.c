@@ -0,0 +1,145 @@
+#include "../../include/pagerank.h"
+#include "../../include/parallel.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @brief Build a skewed random graph with the R-MAT generator
+ *
+ * @param csr The frozen graph to build
+ * @param scale The graph has 2^scale vertices
+ * @param edgefactor The average out-degree
+ * @return 0 on success or -1 on failure.
+ */
+int build_rmat(CsrGraph* csr, int scale, int edgefactor);
+
+/**
+ * @brief Rank a graph & report the edge throughput
+ *
+ * @param csr The graph to rank
+ * @param mode Whether to pull or push rank along the edges
+ * @param nthreads The number of threads to use
+ * @param rank Filled with the rank of each vertex
+ * @return 0 on success or -1 on failure.
+ */
+int measure(const CsrGraph* csr, PageRankMode mode, int nthreads, double* rank);
+
+int main(int argc, char* argv[]) {
+    CsrGraph csr;
+    double* pulled;
+    double* pushed;
+    double diff;
+    int scale, maxthreads, nthreads, v;
+
+    scale = argc > 1 ? atoi(argv[1]) : 20;
+    maxthreads = parallel_threads(argc > 2 ? atoi(argv[2]) : 0);
+    if (scale < 1 || scale > 28) {
+        fputs("usage: prank [scale] [threads]\n", stderr);
+        return 1;
+    }
+
+    if (build_rmat(&csr, scale, 16)) {
+        fputs("Error building graph!\n", stderr);
+        return 1;
+    }
+
+    pulled = malloc(csr_vcount(&csr) * sizeof(double));
+    pushed = malloc(csr_vcount(&csr) * sizeof(double));
+    if (!pulled || !pushed) {
+        fputs("Error allocating memory!\n", stderr);
+        return 1;
+    }
+
+    printf("%d vertices, %d edges\n", csr_vcount(&csr), csr_ecount(&csr));
+    printf("%-6s %8s %6s %10s %14s %14s\n", "mode", "threads", "iters", "time (ms)", "edges/s", "edges/s/core");
+
+    for (nthreads = 1; nthreads <= maxthreads; nthreads = nthreads < maxthreads && nthreads * 2 > maxthreads ? maxthreads : nthreads * 2) {
+        if (measure(&csr, PAGERANK_PULL, nthreads, pulled) || measure(&csr, PAGERANK_PUSH, nthreads, pushed)) {
+            fputs("pagerank encountered an error, exiting...\n", stderr);
+            return 1;
+        }
+    }
+
+    /* Both directions compute the same ranks */
+    diff = 0.0;
+    for (v = 0; v < csr_vcount(&csr); v++) {
+        diff = fmax(diff, fabs(pulled[v] - pushed[v]));
+    }
+
+    printf("max difference between pull & push: %g\n", diff);
+
+    free(pulled);
+    free(pushed);
+    csr_destroy(&csr);
+
+    return 0;
+}
+
+int build_rmat(CsrGraph* csr, int scale, int edgefactor) {
+    unsigned long long seed;
+    double r;
+    int* edges;
+    int ecount, e, bit, u, v, rc;
+
+    ecount = edgefactor << scale;
+    edges = malloc(2 * (size_t) ecount * sizeof(int));
+    if (!edges) {
+        return -1;
+    }
+
+    /* Recursively pick a quadrant of the adjacency matrix for each edge */
+    seed = 88172645463325252ULL;
+    for (e = 0; e < ecount; e++) {
+        u = v = 0;
+
+        for (bit = 0; bit < scale; bit++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            r = (seed >> 11) * (1.0 / 9007199254740992.0);
+
+            if (r < 0.57) {
+                continue;
+            }
+            else if (r < 0.76) {
+                v |= 1 << bit;
+            }
+            else if (r < 0.95) {
+                u |= 1 << bit;
+            }
+            else {
+                u |= 1 << bit;
+                v |= 1 << bit;
+            }
+        }
+
+        edges[2 * e] = u;
+        edges[2 * e + 1] = v;
+    }
+
+    rc = csr_from_edges(csr, 1 << scale, edges, ecount);
+    free(edges);
+    return rc;
+}
+
+int measure(const CsrGraph* csr, PageRankMode mode, int nthreads, double* rank) {
+    struct timespec begin, end;
+    double seconds, rate;
+    int iters;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    iters = pagerank(csr, 0.85, 1e-6, 100, mode, nthreads, rank);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (iters < 0) {
+        return -1;
+    }
+
+    seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+    rate = (double) csr_ecount(csr) * iters / seconds;
+
+    printf("%-6s %8d %6d %10.1f %14.3g %14.3g\n", mode == PAGERANK_PULL ? "pull" : "push",
+           nthreads, iters, seconds * 1e3, rate, rate / nthreads);
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "../../include/bfs.h"
+#include "../../include/hyperanf.h"
+#include "../../include/parallel.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Number of vertices checked against an exact search */
+#define SAMPLES 64
+
+/**
+ * @brief Build a side x side grid with each cell joined to its four neighbours
+ *
+ * @param csr The frozen graph to build
+ * @param side The number of cells along each side
+ * @return 0 on success or -1 on failure.
+ */
+int build_grid(CsrGraph* csr, int side);
+
+/**
+ * @brief Count a vertex found by the search
+ *
+ * @param vertex The vertex found
+ * @param depth Its hop count from the start
+ * @param arg Counts of vertices found at each hop count
+ * @return 0 to keep searching.
+ */
+int count_vertex(int vertex, int depth, void* arg);
+
+int main(int argc, char* argv[]) {
+    struct timespec begin, end;
+    BfsWorkspace ws;
+    CsrGraph csr;
+    double* nf;
+    double* reach;
+    double error, worst, mean, exact;
+    int* found;
+    int side, hops, log2m, maxthreads, v, t, i;
+
+    side = argc > 1 ? atoi(argv[1]) : 128;
+    error = argc > 2 ? atof(argv[2]) : 0.05;
+    maxthreads = parallel_threads(argc > 3 ? atoi(argv[3]) : 0);
+    if (side < 2 || side > 4096 || error <= 0.0) {
+        fputs("usage: reach [side] [error] [threads]\n", stderr);
+        return 1;
+    }
+
+    if (build_grid(&csr, side)) {
+        fputs("Error building graph!\n", stderr);
+        return 1;
+    }
+
+    /* The target is a worst case, so keep three standard errors within it */
+    hops = side / 2;
+    log2m = hyperanf_log2m(error / 3);
+    nf = malloc((hops + 1) * sizeof(double));
+    reach = malloc(csr_vcount(&csr) * sizeof(double));
+    found = calloc(hops + 1, sizeof(int));
+    if (!nf || !reach || !found || bfs_workspace_init(&ws, csr_vcount(&csr))) {
+        fputs("Error allocating memory!\n", stderr);
+        return 1;
+    }
+
+    printf("%d vertices, %d edges, %d registers per vertex\n", csr_vcount(&csr), csr_ecount(&csr), 1 << log2m);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    hops = hyperanf(&csr, log2m, hops, maxthreads, nf, reach);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (hops < 0) {
+        fputs("hyperanf encountered an error, exiting...\n", stderr);
+        return 1;
+    }
+
+    printf("%d hops in %.1f ms using %d threads\n", hops,
+           (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6, maxthreads);
+
+    puts("hops  pairs within reach");
+    for (t = 0; t <= hops; t += hops / 8 > 0 ? hops / 8 : 1) {
+        printf("%4d  %.4g\n", t, nf[t]);
+    }
+
+    /* Compare the final estimates with exact counts for a spread of vertices */
+    worst = mean = 0.0;
+    for (i = 0; i < SAMPLES; i++) {
+        v = (int) ((long) i * csr_vcount(&csr) / SAMPLES);
+
+        for (t = 0; t <= hops; t++) {
+            found[t] = 0;
+        }
+
+        bfs_visit(&ws, &csr, v, hops, count_vertex, found);
+
+        exact = 0.0;
+        for (t = 0; t <= hops; t++) {
+            exact += found[t];
+        }
+
+        worst = fmax(worst, fabs(reach[v] - exact) / exact);
+        mean += fabs(reach[v] - exact) / exact / SAMPLES;
+    }
+
+    printf("relative error over %d vertices: mean %.3f, worst %.3f (target %.3f)\n", SAMPLES, mean, worst, error);
+
+    bfs_workspace_destroy(&ws);
+    free(nf);
+    free(reach);
+    free(found);
+    csr_destroy(&csr);
+
+    return 0;
+}
+
+int build_grid(CsrGraph* csr, int side) {
+    int* edges;
+    int ecount, x, y, rc;
+
+    edges = malloc(8 * (size_t) side * side * sizeof(int));
+    if (!edges) {
+        return -1;
+    }
+
+    ecount = 0;
+    for (y = 0; y < side; y++) {
+        for (x = 0; x < side; x++) {
+            if (x + 1 < side) {
+                edges[2 * ecount] = y * side + x;
+                edges[2 * ecount++ + 1] = y * side + x + 1;
+                edges[2 * ecount] = y * side + x + 1;
+                edges[2 * ecount++ + 1] = y * side + x;
+            }
+
+            if (y + 1 < side) {
+                edges[2 * ecount] = y * side + x;
+                edges[2 * ecount++ + 1] = (y + 1) * side + x;
+                edges[2 * ecount] = (y + 1) * side + x;
+                edges[2 * ecount++ + 1] = y * side + x;
+            }
+        }
+    }
+
+    rc = csr_from_edges(csr, side * side, edges, ecount);
+    free(edges);
+    return rc;
+}
+
+int count_vertex(int vertex, int depth, void* arg) {
+    int* found = arg;
+
+    (void) vertex;
+    found[depth] += 1;
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include "../../include/bfs.h"
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Cache counters
+ *
+ * File descriptors for the hardware cache events sampled around each BFS.
+ */
+typedef struct CacheCounters_ {
+    int l1_access; /**< L1 data cache reads */
+    int l1_miss; /**< L1 data cache read misses */
+    int llc_access; /**< Last level cache reads */
+    int llc_miss; /**< Last level cache read misses */
+} CacheCounters;
+
+/**
+ * @brief Open a hardware cache event for this process
+ *
+ * @param cache The PERF_COUNT_HW_CACHE_* cache to count
+ * @param result Whether to count accesses or misses
+ * @return A file descriptor or -1 if the event is unavailable.
+ */
+int open_cache_event(int cache, int result);
+
+/**
+ * @brief Read the value of an event
+ *
+ * @param fd The event's file descriptor
+ * @return The event count or -1 if the event is unavailable.
+ */
+long long read_event(int fd);
+
+/**
+ * @brief Build a grid graph with shuffled vertex numbers
+ *
+ * Build a side x side grid, with edges in both directions between
+ * neighbouring cells, and number its vertices in random order so that
+ * neighbours end up scattered in memory.
+ *
+ * @param csr The frozen graph to build
+ * @param side The number of cells along each side of the grid
+ * @return 0 on success or -1 on failure.
+ */
+int build_grid(CsrGraph* csr, int side);
+
+/**
+ * @brief Run and measure a breadth-first search
+ *
+ * @param csr The graph to search
+ * @param start The vertex to start from
+ * @param hops Filled with the hop count of each vertex
+ * @param counters The cache counters to sample
+ * @param label The name of the vertex order being measured
+ * @return 0 on success or -1 on failure.
+ */
+int measure(const CsrGraph* csr, int start, int* hops, CacheCounters* counters, const char* label);
+
+int main(int argc, char* argv[]) {
+    static const CsrOrder orders[] = { CSR_ORDER_BFS, CSR_ORDER_RCM, CSR_ORDER_DEGREE, CSR_ORDER_HUB };
+    static const char* names[] = { "bfs", "rcm", "degree", "hub" };
+    CacheCounters counters;
+    CsrGraph csr;
+    CsrGraph reordered;
+    int* hops;
+    int* rehops;
+    int* perm;
+    int* iperm;
+    int side, i, v;
+
+    side = argc > 1 ? atoi(argv[1]) : 1024;
+    if (side < 2) {
+        fputs("usage: reorder [side]\n", stderr);
+        return 1;
+    }
+
+    if (build_grid(&csr, side)) {
+        fputs("Error building graph!\n", stderr);
+        return 1;
+    }
+
+    hops = malloc(csr_vcount(&csr) * sizeof(int));
+    rehops = malloc(csr_vcount(&csr) * sizeof(int));
+    perm = malloc(csr_vcount(&csr) * sizeof(int));
+    iperm = malloc(csr_vcount(&csr) * sizeof(int));
+    if (!hops || !rehops || !perm || !iperm) {
+        fputs("Error allocating memory!\n", stderr);
+        return 1;
+    }
+
+    counters.l1_access = open_cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_ACCESS);
+    counters.l1_miss = open_cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS);
+    counters.llc_access = open_cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_ACCESS);
+    counters.llc_miss = open_cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_MISS);
+
+    printf("%d vertices, %d edges\n", csr_vcount(&csr), csr_ecount(&csr));
+    printf("%-10s %10s %10s %10s\n", "order", "time (ms)", "L1 miss", "LLC miss");
+
+    if (measure(&csr, 0, hops, &counters, "original")) {
+        fputs("bfs encountered an error, exiting...\n", stderr);
+        return 1;
+    }
+
+    for (i = 0; i < (int) (sizeof(orders) / sizeof(orders[0])); i++) {
+        if (csr_reorder(&reordered, &csr, orders[i], perm, iperm)) {
+            fputs("Error reordering graph!\n", stderr);
+            return 1;
+        }
+
+        if (measure(&reordered, perm[0], rehops, &counters, names[i])) {
+            fputs("bfs encountered an error, exiting...\n", stderr);
+            return 1;
+        }
+
+        /* Relabeling must not change any hop count */
+        for (v = 0; v < csr_vcount(&csr); v++) {
+            if (rehops[perm[v]] != hops[v]) {
+                fprintf(stderr, "%s order changed the hop count of vertex %d\n", names[i], v);
+                return 1;
+            }
+        }
+
+        csr_destroy(&reordered);
+    }
+
+    free(hops);
+    free(rehops);
+    free(perm);
+    free(iperm);
+    csr_destroy(&csr);
+
+    return 0;
+}
+
+int open_cache_event(int cache, int result) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+long long read_event(int fd) {
+    long long count;
+
+    if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count)) {
+        return -1;
+    }
+
+    return count;
+}
+
+int build_grid(CsrGraph* csr, int side) {
+    int* label;
+    int* edges;
+    int vcount, ecount, row, col, v, i, j, tmp;
+    unsigned int seed;
+
+    vcount = side * side;
+    label = malloc(vcount * sizeof(int));
+    edges = malloc(8 * (size_t) vcount * sizeof(int));
+    if (!label || !edges) {
+        free(label);
+        free(edges);
+        return -1;
+    }
+
+    /* Shuffle the vertex numbers */
+    seed = 12345;
+    for (v = 0; v < vcount; v++) {
+        label[v] = v;
+    }
+
+    for (i = vcount - 1; i > 0; i--) {
+        seed = seed * 1103515245 + 12345;
+        j = (int) ((seed >> 8) % (unsigned int) (i + 1));
+        tmp = label[i];
+        label[i] = label[j];
+        label[j] = tmp;
+    }
+
+    /* Connect each cell to its right & lower neighbours in both directions */
+    ecount = 0;
+    for (row = 0; row < side; row++) {
+        for (col = 0; col < side; col++) {
+            v = label[row * side + col];
+
+            if (col + 1 < side) {
+                edges[2 * ecount] = v;
+                edges[2 * ecount + 1] = label[row * side + col + 1];
+                ecount++;
+                edges[2 * ecount] = label[row * side + col + 1];
+                edges[2 * ecount + 1] = v;
+                ecount++;
+            }
+
+            if (row + 1 < side) {
+                edges[2 * ecount] = v;
+                edges[2 * ecount + 1] = label[(row + 1) * side + col];
+                ecount++;
+                edges[2 * ecount] = label[(row + 1) * side + col];
+                edges[2 * ecount + 1] = v;
+                ecount++;
+            }
+        }
+    }
+
+    i = csr_from_edges(csr, vcount, edges, ecount);
+
+    free(label);
+    free(edges);
+    return i;
+}
+
+int measure(const CsrGraph* csr, int start, int* hops, CacheCounters* counters, const char* label) {
+    int fds[4] = { counters->l1_access, counters->l1_miss, counters->llc_access, counters->llc_miss };
+    long long counts[4];
+    struct timespec begin, end;
+    double ms;
+    int i, rc;
+
+    for (i = 0; i < 4; i++) {
+        if (fds[i] >= 0) {
+            ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    rc = bfs_csr(csr, start, hops);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    for (i = 0; i < 4; i++) {
+        if (fds[i] >= 0) {
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+        counts[i] = read_event(fds[i]);
+    }
+
+    if (rc) {
+        return rc;
+    }
+
+    ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+    printf("%-10s %10.2f", label, ms);
+
+    /* Report miss rates, or n/a where the kernel won't count for us */
+    for (i = 0; i < 4; i += 2) {
+        if (counts[i] > 0 && counts[i + 1] >= 0) {
+            printf(" %9.2f%%", 100.0 * counts[i + 1] / counts[i]);
+        }
+        else {
+            printf(" %10s", "n/a");
+        }
+    }
+
+    puts("");
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include "../../include/bistree.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Set operations timed, by name */
+static const char* ops[] = { "union", "intersect", "difference" };
+
+/**
+ * @brief Order two integers stored directly in data pointers
+ *
+ * @param key1 The first integer
+ * @param key2 The second integer
+ * @return -1, 0 or 1 as the first is less than, equal to or greater than the second.
+ */
+int compare_ints(const void* key1, const void* key2);
+
+/**
+ * @brief Map an integer stored in a data pointer to a prefix that orders the same way
+ *
+ * @param data The integer
+ * @return The prefix.
+ */
+unsigned long long int_prefix(const void* data);
+
+/**
+ * @brief Check that trees ordered differently are refused & alike ones combined
+ *
+ * @return 0 if the checks pass or -1 if not.
+ */
+int check_prefixes(void);
+
+/**
+ * @brief Build a tree holding every step-th integer below count * step
+ *
+ * @param tree The tree to build
+ * @param count The number of entries
+ * @param step The gap between entries
+ * @return 0 on success or -1 on failure.
+ */
+int build_multiples(BisTree* tree, int count, int step);
+
+/**
+ * @brief Combine two trees one entry at a time with inserts, lookups & removes
+ *
+ * @param result The tree holding the result
+ * @param tree1 The first tree, which may become the result
+ * @param tree2 The second tree, which is left as it was
+ * @param op Which set operation to perform
+ * @return 0 on success or -1 on failure.
+ */
+int combine_slowly(BisTree* result, BisTree* tree1, BisTree* tree2, int op);
+
+/**
+ * @brief Time one set operation on fresh trees & report it
+ *
+ * @param size1 The number of entries in the first tree
+ * @param size2 The number of entries in the second tree
+ * @param op Which set operation to perform
+ * @param nthreads The number of threads for the join-based operation, or 0 for one entry at a time
+ * @return 0 on success or -1 on failure.
+ */
+int measure(int size1, int size2, int op, int nthreads);
+
+int main(int argc, char* argv[]) {
+    int size, maxthreads, nthreads, small, op;
+
+    size = argc > 1 ? atoi(argv[1]) : 1 << 20;
+    maxthreads = argc > 2 ? atoi(argv[2]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (size < 64 || maxthreads < 1 || maxthreads > 64) {
+        fputs("usage: setops [size] [threads]\n", stderr);
+        return 1;
+    }
+
+    if (check_prefixes()) {
+        fputs("union of trees with different prefixes went wrong!\n", stderr);
+        return 1;
+    }
+
+    /* Zero threads stands for one insert, lookup or remove at a time */
+    printf("%-10s %10s %10s %8s %12s %10s\n", "op", "size1", "size2", "threads", "time (ms)", "result");
+
+    /* Trees of the same size, then one far smaller than the other */
+    for (small = 0; small < 2; small++) {
+        for (op = 0; op < 3; op++) {
+            if (measure(size, small ? size / 64 : size, op, 0)) {
+                fputs("Error building trees!\n", stderr);
+                return 1;
+            }
+
+            for (nthreads = 1; nthreads <= maxthreads; nthreads = nthreads < maxthreads && nthreads * 2 > maxthreads ? maxthreads : nthreads * 2) {
+                if (measure(size, small ? size / 64 : size, op, nthreads)) {
+                    fputs("Error building trees!\n", stderr);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+int compare_ints(const void* key1, const void* key2) {
+    intptr_t k1 = (intptr_t) key1;
+    intptr_t k2 = (intptr_t) key2;
+
+    return (k1 > k2) - (k1 < k2);
+}
+
+unsigned long long int_prefix(const void* data) {
+    /* Flip the sign bit so negative integers order below positive ones */
+    return (unsigned long long) (intptr_t) data ^ (1ULL << 63);
+}
+
+int check_prefixes(void) {
+    BisTree tree1, tree2, result;
+    void* data;
+    int rc, i;
+
+    if (build_multiples(&tree1, 100, 2) || build_multiples(&tree2, 100, 3)) {
+        return -1;
+    }
+
+    /* Nodes of the second tree carry no prefix, so the first must refuse them */
+    bistree_set_prefix(&tree1, int_prefix);
+    rc = bistree_union(&result, &tree1, &tree2, 1) == -1 && bistree_size(&tree1) == 100 && bistree_size(&tree2) == 100 ? 0 : -1;
+
+    /* Once both agree, every key from either tree must come through */
+    bistree_set_prefix(&tree2, int_prefix);
+    if (!rc && !bistree_union(&result, &tree1, &tree2, 1)) {
+        for (i = 0; i < 300; i++) {
+            data = (void*) (intptr_t) i;
+            if (bistree_lookup(&result, &data) != ((i % 2 == 0 && i < 200) || i % 3 == 0 ? 0 : -1)) {
+                rc = -1;
+            }
+        }
+
+        bistree_destroy(&result);
+    }
+    else {
+        rc = -1;
+    }
+
+    bistree_destroy(&tree1);
+    bistree_destroy(&tree2);
+    return rc;
+}
+
+int build_multiples(BisTree* tree, int count, int step) {
+    void** items;
+    int i, rc;
+
+    items = malloc(count * sizeof(void*));
+    if (!items) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        items[i] = (void*) ((intptr_t) i * step);
+    }
+
+    bistree_init(tree, compare_ints, NULL);
+    rc = bistree_build_sorted(tree, items, count);
+
+    free(items);
+    return rc;
+}
+
+int combine_slowly(BisTree* result, BisTree* tree1, BisTree* tree2, int op) {
+    BisCursor cursor;
+    void* data;
+    int retval;
+
+    bistree_init(result, compare_ints, NULL);
+
+    for (retval = bistree_seek(tree2, &cursor, NULL); !retval; retval = bistree_next(&cursor)) {
+        data = bistree_cursor_data(&cursor);
+
+        if (op == 0 && bistree_insert(tree1, data) < 0) {
+            return -1;
+        }
+        else if (op == 1 && !bistree_lookup(tree1, &data) && bistree_insert(result, data) < 0) {
+            return -1;
+        }
+        else if (op == 2) {
+            bistree_remove(tree1, data);
+        }
+    }
+
+    /* Union & difference build their result in the first tree */
+    if (op != 1) {
+        bistree_destroy(result);
+        *result = *tree1;
+        bistree_init(tree1, compare_ints, NULL);
+    }
+
+    return 0;
+}
+
+int measure(int size1, int size2, int op, int nthreads) {
+    struct timespec begin, end;
+    BisTree tree1, tree2, result;
+    BisTreeStats stats;
+    int rc;
+
+    /* Spread the second tree over the same range with an odd step, so every other entry overlaps */
+    if (build_multiples(&tree1, size1, 2) || build_multiples(&tree2, size2, 2 * (size1 / size2) + 1)) {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    if (nthreads) {
+        rc = op == 0 ? bistree_union(&result, &tree1, &tree2, nthreads)
+             : op == 1 ? bistree_intersect(&result, &tree1, &tree2, nthreads)
+             : bistree_difference(&result, &tree1, &tree2, nthreads);
+    }
+    else {
+        rc = combine_slowly(&result, &tree1, &tree2, op);
+    }
+
+    /* The join-based operations consume their inputs, so both ways end with them gone */
+    bistree_destroy(&tree1);
+    bistree_destroy(&tree2);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (!rc) {
+        bistree_stats(&result, &stats);
+        printf("%-10s %10d %10d %8d %12.1f %10d\n", ops[op], size1, size2, nthreads,
+               ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / 1e6, stats.live);
+    }
+
+    bistree_destroy(&result);
+    return rc;
+}
@@ -0,0 +1,226 @@
+#include "../../include/bistree.h"
+#include "../../include/pbistree.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/* Keys live in 0..KEYS-1 & roughly half are in the tree at any time */
+#define KEYS 1000000
+
+/**
+ * @brief Shared benchmark state
+ */
+typedef struct Bench_ {
+    PbisTree* ptree; /**< The persistent tree, or NULL to lock the plain tree */
+    BisTree* tree; /**< The plain tree, guarded by lock */
+    pthread_rwlock_t lock; /**< Guards the plain tree */
+    atomic_int running; /**< Cleared to stop all threads */
+    atomic_long lookups; /**< Lookups completed by readers */
+    atomic_long updates; /**< Inserts & removes completed by the writer */
+} Bench;
+
+/**
+ * @brief Advance a simple linear congruential generator
+ *
+ * @param seed The generator state
+ * @return The next pseudo-random number.
+ */
+unsigned int next_random(unsigned int* seed);
+
+/**
+ * @brief Compare two keys stored directly in the data pointers
+ *
+ * @param key1 The first key
+ * @param key2 The second key
+ * @return 1 if key1 > key2, -1 if key1 < key2, 0 if equal.
+ */
+int compare_keys(const void* key1, const void* key2);
+
+/**
+ * @brief Look up random keys until told to stop
+ *
+ * @param arg The shared benchmark state
+ * @return NULL
+ */
+void* reader(void* arg);
+
+/**
+ * @brief Toggle random keys in & out of the tree until told to stop
+ *
+ * @param arg The shared benchmark state
+ * @return NULL
+ */
+void* writer(void* arg);
+
+/**
+ * @brief Run one round of readers against a steady writer
+ *
+ * @param bench The shared benchmark state
+ * @param nthreads The number of reader threads
+ */
+void measure(Bench* bench, int nthreads);
+
+int main(int argc, char* argv[]) {
+    BisTree tree;
+    PbisTree ptree;
+    Bench bench;
+    unsigned int seed;
+    intptr_t key;
+    int maxthreads, nthreads, i;
+
+    maxthreads = argc > 1 ? atoi(argv[1]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (maxthreads < 1 || maxthreads > 64) {
+        fputs("usage: snapshot [threads]\n", stderr);
+        return 1;
+    }
+
+    bistree_init(&tree, compare_keys, NULL);
+    if (pbistree_init(&ptree, compare_keys, NULL)) {
+        fputs("Error building tree!\n", stderr);
+        return 1;
+    }
+
+    /* Both trees start with the same random half of the keys */
+    seed = 7;
+    for (i = 0; i < KEYS / 2; i++) {
+        key = next_random(&seed) % KEYS;
+        if (bistree_insert(&tree, (void*) key) < 0 || pbistree_insert(&ptree, (void*) key) < 0) {
+            fputs("Error building tree!\n", stderr);
+            return 1;
+        }
+    }
+
+    bench.tree = &tree;
+    pthread_rwlock_init(&bench.lock, NULL);
+    printf("%-10s %8s %14s %14s\n", "tree", "readers", "lookups/s", "updates/s");
+
+    for (nthreads = 1; nthreads <= maxthreads; nthreads = nthreads < maxthreads && nthreads * 2 > maxthreads ? maxthreads : nthreads * 2) {
+        bench.ptree = NULL;
+        measure(&bench, nthreads);
+
+        bench.ptree = &ptree;
+        measure(&bench, nthreads);
+    }
+
+    pthread_rwlock_destroy(&bench.lock);
+    pbistree_destroy(&ptree);
+    bistree_destroy(&tree);
+    return 0;
+}
+
+unsigned int next_random(unsigned int* seed) {
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+int compare_keys(const void* key1, const void* key2) {
+    intptr_t k1 = (intptr_t) key1;
+    intptr_t k2 = (intptr_t) key2;
+
+    return k1 > k2 ? 1 : k1 < k2 ? -1 : 0;
+}
+
+void* reader(void* arg) {
+    Bench* bench = arg;
+    const PbisNode* root;
+    EpochThread self;
+    unsigned int seed;
+    void* data;
+    long count;
+    int i;
+
+    seed = (unsigned int) (size_t) &self;
+    count = 0;
+
+    if (bench->ptree) {
+        pbistree_attach(bench->ptree, &self);
+    }
+
+    while (atomic_load_explicit(&bench->running, memory_order_relaxed)) {
+        /* Pin one snapshot, or take the lock once, for a small batch of lookups */
+        if (bench->ptree) {
+            root = pbistree_pin(bench->ptree, &self);
+            for (i = 0; i < 16; i++) {
+                data = (void*) (intptr_t) (next_random(&seed) % KEYS);
+                pbistree_lookup(bench->ptree, root, &data);
+            }
+            pbistree_unpin(&self);
+        }
+        else {
+            pthread_rwlock_rdlock(&bench->lock);
+            for (i = 0; i < 16; i++) {
+                data = (void*) (intptr_t) (next_random(&seed) % KEYS);
+                bistree_lookup(bench->tree, &data);
+            }
+            pthread_rwlock_unlock(&bench->lock);
+        }
+
+        count += 16;
+    }
+
+    if (bench->ptree) {
+        pbistree_detach(bench->ptree, &self);
+    }
+
+    atomic_fetch_add(&bench->lookups, count);
+    return NULL;
+}
+
+void* writer(void* arg) {
+    Bench* bench = arg;
+    unsigned int seed;
+    long count;
+    void* key;
+
+    seed = 42;
+    count = 0;
+
+    while (atomic_load_explicit(&bench->running, memory_order_relaxed)) {
+        key = (void*) (intptr_t) (next_random(&seed) % KEYS);
+
+        /* Toggle the key so the tree keeps roughly the same size */
+        if (bench->ptree) {
+            if (pbistree_insert(bench->ptree, key) == 1) {
+                pbistree_remove(bench->ptree, key);
+            }
+        }
+        else {
+            pthread_rwlock_wrlock(&bench->lock);
+            if (bistree_insert(bench->tree, key) == 1) {
+                bistree_remove(bench->tree, key);
+            }
+            pthread_rwlock_unlock(&bench->lock);
+        }
+
+        count++;
+    }
+
+    atomic_fetch_add(&bench->updates, count);
+    return NULL;
+}
+
+void measure(Bench* bench, int nthreads) {
+    pthread_t threads[64];
+    pthread_t writer_thread;
+    int i;
+
+    atomic_init(&bench->running, 1);
+    atomic_init(&bench->lookups, 0);
+    atomic_init(&bench->updates, 0);
+
+    pthread_create(&writer_thread, NULL, writer, bench);
+    for (i = 0; i < nthreads; i++) {
+        pthread_create(&threads[i], NULL, reader, bench);
+    }
+
+    sleep(1);
+    atomic_store(&bench->running, 0);
+
+    for (i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_join(writer_thread, NULL);
+
+    printf("%-10s %8d %14ld %14ld\n", bench->ptree ? "persistent" : "rwlock", nthreads,
+           atomic_load(&bench->lookups), atomic_load(&bench->updates));
+}
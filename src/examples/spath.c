@@ -1,14 +1,72 @@
 #include "../../include/bfs.h"
+#include "../../include/intern.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Number of predecessor trees the query server keeps */
+#define CACHE_TREES 64
+
+/* Longest vertex name the query server accepts */
+#define MAX_NAME 255
+
+/**
+ * @brief A cached breadth-first search tree
+ *
+ * Hop count & predecessor of every vertex, searched from one source.
+ */
+typedef struct Tree_ {
+    int source; /**< The vertex searched from, or -1 if unused */
+    int* dist; /**< Hop count of each vertex, -1 if unreached */
+    int* pred; /**< Predecessor of each vertex on its shortest path */
+    struct Tree_* prev; /**< The next more recently used tree */
+    struct Tree_* next; /**< The next less recently used tree */
+} Tree;
+
+/**
+ * @brief The query server
+ *
+ * Data structure holding the loaded graph, the tree cache & statistics.
+ */
+typedef struct Server_ {
+    CsrGraph csr; /**< The graph, numbered by interned name */
+    BfsWorkspace workspace; /**< Scratch space for searches */
+    Tree trees[CACHE_TREES]; /**< The cached trees */
+    Tree* head; /**< The most recently used tree */
+    Tree* tail; /**< The least recently used tree */
+    int* cached; /**< Cache slot of each source, or -1 */
+    int* path; /**< Scratch space for walking a path backwards */
+    long hits; /**< Queries answered from the cache */
+    long misses; /**< Queries that needed a search */
+    double* latency; /**< Time taken by each query, in microseconds */
+    long nqueries; /**< The number of queries answered */
+    long capacity; /**< Room in the latency array */
+} Server;
+
+/* Names are interned once, so vertices carry a small id instead of a string */
+InternTable names;
 
 BfsVertex* create_vertex(const char* name) {
-    BfsVertex* v = malloc(sizeof(BfsVertex));
+    BfsVertex* v;
+    int id;
+
+    id = intern_id(&names, name);
+    if (id < 0) {
+        return NULL;
+    }
+
+    v = malloc(sizeof(BfsVertex));
     if (!v) {
         return NULL;
     }
 
-    v->data = (void*) name;
+    v->data = (void*) (intptr_t) id;
 
     v->path = malloc(sizeof(List));
     if (!v->path) {
@@ -16,6 +74,7 @@ BfsVertex* create_vertex(const char* name) {
         return NULL;
     }
 
+    list_init(v->path, NULL);
     return v;
 }
 
@@ -55,42 +114,509 @@ void build_graph(Graph* graph) {
     graph_ins_edge(graph, n5, n6);
 }
 
-int compare_vertices_by_name(const void* vertex1, const void* vertex2) {
-    const char* s1 = ((const BfsVertex*) vertex1)->data;
-    const char* s2 = ((const BfsVertex*) vertex2)->data;
+int compare_vertices_by_id(const void* vertex1, const void* vertex2) {
+    return ((const BfsVertex*) vertex1)->data == ((const BfsVertex*) vertex2)->data;
+}
 
-    return strcmp(s1, s2) == 0;
+const char* vertex_name(const void* data) {
+    return intern_name(&names, (int) (intptr_t) data);
 }
 
-int main(void) {
+/**
+ * @brief Load a graph of "source target" name pairs, one edge per line
+ *
+ * @param server The server to load the graph into
+ * @param path The file to read
+ * @return 0 on success or -1 on failure.
+ */
+int load_graph(Server* server, const char* path);
+
+/**
+ * @brief Release everything the server holds
+ *
+ * @param server The server to tear down
+ */
+void destroy_server(Server* server);
+
+/**
+ * @brief Fetch the search tree of a source, searching only on a cache miss
+ *
+ * @param server The server
+ * @param source The vertex to search from
+ * @return The tree or NULL on failure.
+ */
+Tree* find_tree(Server* server, int source);
+
+/**
+ * @brief Answer a single "source target" query
+ *
+ * @param server The server
+ * @param line The query
+ * @param out Where to write the answer
+ * @return 0 on success or -1 on failure.
+ */
+int answer(Server* server, const char* line, FILE* out);
+
+/**
+ * @brief Answer queries line by line until the input runs out
+ *
+ * @param server The server
+ * @param in Where to read queries
+ * @param out Where to write answers
+ * @return 0 on success or -1 on failure.
+ */
+int serve_stream(Server* server, FILE* in, FILE* out);
+
+/**
+ * @brief Answer queries from clients of a Unix socket until interrupted
+ *
+ * @param server The server
+ * @param path The socket to listen on
+ * @return 0 on success or -1 on failure.
+ */
+int serve_socket(Server* server, const char* path);
+
+/**
+ * @brief Order two query latencies
+ *
+ * @param key1 The first latency
+ * @param key2 The second latency
+ * @return -1, 0 or 1 as the first is less than, equal to or greater than the second.
+ */
+int compare_latency(const void* key1, const void* key2);
+
+/**
+ * @brief Print latency & throughput statistics
+ *
+ * @param server The server
+ * @param seconds How long the server ran
+ */
+void report(Server* server, double seconds);
+
+/**
+ * @brief Note a request to stop serving
+ *
+ * @param signum The signal received
+ */
+void stop(int signum);
+
+/* Set once the server has been asked to stop */
+volatile sig_atomic_t stopping;
+
+int main(int argc, char* argv[]) {
+    struct sigaction action;
+    struct timespec begin, end;
+    Server server;
     Graph graph;
     List hops;
     ListElmt* elem;
+    int rc;
+
+    if (intern_init(&names)) {
+        fputs("Error allocating memory!\n", stderr);
+        return 1;
+    }
+
+    /* Serve queries against a graph file instead of running the demo */
+    if (argc > 1) {
+        if (strcmp(argv[1], "serve") || argc < 3 || argc > 4) {
+            fputs("usage: spath [serve graph [socket]]\n", stderr);
+            return 1;
+        }
+
+        if (load_graph(&server, argv[2])) {
+            fprintf(stderr, "Error loading graph from %s!\n", argv[2]);
+            return 1;
+        }
+
+        fprintf(stderr, "loaded %d vertices, %d edges\n", csr_vcount(&server.csr), csr_ecount(&server.csr));
+
+        /* Let a signal interrupt accept & reads rather than restart them, so stats still print */
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = stop;
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
 
-    graph_init(&graph, compare_vertices_by_name, free);
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        rc = argc > 3 ? serve_socket(&server, argv[3]) : serve_stream(&server, stdin, stdout);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        report(&server, (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9);
+        destroy_server(&server);
+        intern_destroy(&names);
+        return rc ? 1 : 0;
+    }
+
+    graph_init(&graph, compare_vertices_by_id, free);
 
     build_graph(&graph);
 
     elem = list_head(&graph_adjlists(&graph));
     BfsVertex* start = ((AdjList*)list_data(elem))->vertex;
 
-    int rc = bfs(&graph, start, &hops);
+    rc = bfs(&graph, start, &hops);
     if (rc) {
         fputs("bfs encountered an error, exiting...\n", stderr);
         return 1;
     }
 
-    printf("shortest path from %s to all other nodes\n", (const char*) start->data);
+    printf("shortest path from %s to all other nodes\n", vertex_name(start->data));
 
     for (elem = list_head(&hops); elem != NULL; elem = list_next(elem)) {
         BfsVertex* v = (BfsVertex*)list_data(elem);
-        printf("%s = %d hops: ", (const char*) v->data, list_size(v->path));
+        printf("%s = %d hops: ", vertex_name(v->data), list_size(v->path));
         ListElmt* elem2;
         for (elem2 = list_head(v->path); elem2 != NULL; elem2 = list_next(elem2)) {
-            printf("%s ", (const char*)list_data(elem2));
+            printf("%s ", vertex_name(list_data(elem2)));
         }
         puts("");
     }
 
+    intern_destroy(&names);
+    return 0;
+}
+
+int load_graph(Server* server, const char* path) {
+    char name1[MAX_NAME + 1];
+    char name2[MAX_NAME + 1];
+    FILE* file;
+    int* edges;
+    int* grown;
+    int ecount, capacity, i;
+
+    file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+
+    memset(server, 0, sizeof(Server));
+    ecount = 0;
+    capacity = 1024;
+    edges = malloc(2 * capacity * sizeof(int));
+    if (!edges) {
+        fclose(file);
+        return -1;
+    }
+
+    /* Intern names as they are read, so the frozen graph is numbered by id */
+    while (fscanf(file, "%255s %255s", name1, name2) == 2) {
+        if (ecount == capacity) {
+            capacity *= 2;
+            grown = realloc(edges, 2 * capacity * sizeof(int));
+            if (!grown) {
+                free(edges);
+                fclose(file);
+                return -1;
+            }
+
+            edges = grown;
+        }
+
+        edges[2 * ecount] = intern_id(&names, name1);
+        edges[2 * ecount + 1] = intern_id(&names, name2);
+        if (edges[2 * ecount] < 0 || edges[2 * ecount + 1] < 0) {
+            free(edges);
+            fclose(file);
+            return -1;
+        }
+
+        ecount += 1;
+    }
+
+    fclose(file);
+
+    if (!intern_size(&names) || csr_from_edges(&server->csr, intern_size(&names), edges, ecount)) {
+        free(edges);
+        return -1;
+    }
+
+    free(edges);
+
+    server->capacity = 1024;
+    server->latency = malloc(server->capacity * sizeof(double));
+    server->cached = malloc(csr_vcount(&server->csr) * sizeof(int));
+    server->path = malloc(csr_vcount(&server->csr) * sizeof(int));
+    if (!server->latency || !server->cached || !server->path
+        || bfs_workspace_init(&server->workspace, csr_vcount(&server->csr))) {
+        destroy_server(server);
+        return -1;
+    }
+
+    for (i = 0; i < csr_vcount(&server->csr); i++) {
+        server->cached[i] = -1;
+    }
+
+    /* Chain every slot into the recency list, all of them unused to begin with */
+    for (i = 0; i < CACHE_TREES; i++) {
+        server->trees[i].source = -1;
+        server->trees[i].dist = malloc(csr_vcount(&server->csr) * sizeof(int));
+        server->trees[i].pred = malloc(csr_vcount(&server->csr) * sizeof(int));
+        server->trees[i].prev = i > 0 ? &server->trees[i - 1] : NULL;
+        server->trees[i].next = i + 1 < CACHE_TREES ? &server->trees[i + 1] : NULL;
+
+        if (!server->trees[i].dist || !server->trees[i].pred) {
+            destroy_server(server);
+            return -1;
+        }
+    }
+
+    server->head = &server->trees[0];
+    server->tail = &server->trees[CACHE_TREES - 1];
+
+    return 0;
+}
+
+void destroy_server(Server* server) {
+    int i;
+
+    for (i = 0; i < CACHE_TREES; i++) {
+        free(server->trees[i].dist);
+        free(server->trees[i].pred);
+    }
+
+    if (server->workspace.visited) {
+        bfs_workspace_destroy(&server->workspace);
+    }
+
+    free(server->cached);
+    free(server->path);
+    free(server->latency);
+    csr_destroy(&server->csr);
+    memset(server, 0, sizeof(Server));
+}
+
+Tree* find_tree(Server* server, int source) {
+    Tree* tree;
+    int v;
+
+    if (server->cached[source] >= 0) {
+        tree = &server->trees[server->cached[source]];
+        server->hits += 1;
+    }
+    else {
+        /* Search again into the least recently used slot */
+        tree = server->tail;
+        if (bfs_visit(&server->workspace, &server->csr, source, -1, NULL, NULL) < 0) {
+            return NULL;
+        }
+
+        if (tree->source >= 0) {
+            server->cached[tree->source] = -1;
+        }
+
+        for (v = 0; v < csr_vcount(&server->csr); v++) {
+            if (bfs_reached(&server->workspace, v)) {
+                tree->dist[v] = bfs_dist(&server->workspace, v);
+                tree->pred[v] = bfs_pred(&server->workspace, v);
+            }
+            else {
+                tree->dist[v] = -1;
+                tree->pred[v] = -1;
+            }
+        }
+
+        tree->source = source;
+        server->cached[source] = (int) (tree - server->trees);
+        server->misses += 1;
+    }
+
+    /* Move the tree to the front of the recency list */
+    if (tree != server->head) {
+        tree->prev->next = tree->next;
+        if (tree->next) {
+            tree->next->prev = tree->prev;
+        }
+        else {
+            server->tail = tree->prev;
+        }
+
+        tree->prev = NULL;
+        tree->next = server->head;
+        server->head->prev = tree;
+        server->head = tree;
+    }
+
+    return tree;
+}
+
+int answer(Server* server, const char* line, FILE* out) {
+    char name1[MAX_NAME + 1];
+    char name2[MAX_NAME + 1];
+    struct timespec begin, end;
+    double* grown;
+    Tree* tree;
+    int source, target, length, v;
+
+    if (sscanf(line, "%255s %255s", name1, name2) != 2) {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    source = intern_lookup(&names, name1);
+    target = intern_lookup(&names, name2);
+
+    if (source < 0 || target < 0) {
+        fprintf(out, "%s %s: unknown vertex\n", name1, name2);
+    }
+    else {
+        tree = find_tree(server, source);
+        if (!tree) {
+            return -1;
+        }
+
+        if (tree->dist[target] < 0) {
+            fprintf(out, "%s %s: unreachable\n", name1, name2);
+        }
+        else {
+            /* Walk back from the target, then print the path forwards */
+            length = 0;
+            for (v = target; v != source; v = tree->pred[v]) {
+                server->path[length++] = v;
+            }
+
+            fprintf(out, "%s %s: %d hops:", name1, name2, tree->dist[target]);
+            while (length > 0) {
+                fprintf(out, " %s", intern_name(&names, server->path[--length]));
+            }
+
+            fputc('\n', out);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (server->nqueries == server->capacity) {
+        grown = realloc(server->latency, 2 * server->capacity * sizeof(double));
+        if (!grown) {
+            return -1;
+        }
+
+        server->latency = grown;
+        server->capacity *= 2;
+    }
+
+    server->latency[server->nqueries++] = (end.tv_sec - begin.tv_sec) * 1e6 + (end.tv_nsec - begin.tv_nsec) / 1e3;
     return 0;
 }
+
+int serve_stream(Server* server, FILE* in, FILE* out) {
+    char line[2 * MAX_NAME + 4];
+
+    while (!stopping) {
+        if (!fgets(line, sizeof(line), in)) {
+            /* A read interrupted by anything but a stop request is retried */
+            if (ferror(in) && errno == EINTR && !stopping) {
+                clearerr(in);
+                continue;
+            }
+
+            break;
+        }
+
+        if (answer(server, line, out)) {
+            return -1;
+        }
+
+        fflush(out);
+    }
+
+    return 0;
+}
+
+int serve_socket(Server* server, const char* path) {
+    struct sockaddr_un address;
+    FILE* in;
+    FILE* out;
+    int listener, client, rc;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+
+    if (bind(listener, (struct sockaddr*) &address, sizeof(address)) || listen(listener, 16)) {
+        close(listener);
+        return -1;
+    }
+
+    fprintf(stderr, "listening on %s\n", path);
+
+    /* Clients are served one after another, each until it hangs up */
+    rc = 0;
+    while (!stopping && !rc) {
+        client = accept(listener, NULL, NULL);
+        if (client < 0) {
+            rc = errno == EINTR ? 0 : -1;
+            continue;
+        }
+
+        in = fdopen(client, "r");
+        out = in ? fdopen(dup(client), "w") : NULL;
+        if (!in || !out) {
+            if (in) {
+                fclose(in);
+            }
+            else {
+                close(client);
+            }
+
+            continue;
+        }
+
+        rc = serve_stream(server, in, out);
+        fclose(in);
+        fclose(out);
+    }
+
+    close(listener);
+    unlink(path);
+    return rc;
+}
+
+int compare_latency(const void* key1, const void* key2) {
+    double l1 = *(const double*) key1;
+    double l2 = *(const double*) key2;
+
+    return (l1 > l2) - (l1 < l2);
+}
+
+void report(Server* server, double seconds) {
+    double total;
+    long i;
+
+    fprintf(stderr, "%ld queries in %.3f s (%.0f queries/s), %ld cache hits, %ld misses\n", server->nqueries,
+            seconds, seconds > 0.0 ? server->nqueries / seconds : 0.0, server->hits, server->misses);
+
+    if (!server->nqueries) {
+        return;
+    }
+
+    total = 0.0;
+    for (i = 0; i < server->nqueries; i++) {
+        total += server->latency[i];
+    }
+
+    qsort(server->latency, server->nqueries, sizeof(double), compare_latency);
+
+    fprintf(stderr, "latency (us): mean %.1f, p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+            total / server->nqueries, server->latency[server->nqueries / 2],
+            server->latency[server->nqueries * 9 / 10], server->latency[server->nqueries * 99 / 100],
+            server->latency[server->nqueries - 1]);
+}
+
+void stop(int signum) {
+    (void) signum;
+    stopping = 1;
+}
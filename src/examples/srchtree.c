@@ -1,4 +1,5 @@
 #include "../../include/bistree.h"
+#include "../../include/tst.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -24,20 +25,16 @@ Contact* create_contact(const char* surname,
 }
 
 void build_contacts(BisTree* contacts) {
-    Contact* c = create_contact("Fonda", "Jane", "0491 570 006");
-    bistree_insert(contacts, c);
+    /* Already in surname order, so the tree can be built in one pass */
+    void* sorted[5];
 
-    c = create_contact("Nixon", "Richard", "0491 571 804");
-    bistree_insert(contacts, c);
+    sorted[0] = create_contact("Bellafonte", "Harry", "1300 975 707");
+    sorted[1] = create_contact("Fonda", "Jane", "0491 570 006");
+    sorted[2] = create_contact("Kelly", "Grace", "0491 578 888");
+    sorted[3] = create_contact("Manson", "Charles", "1800 160 401");
+    sorted[4] = create_contact("Nixon", "Richard", "0491 571 804");
 
-    c = create_contact("Manson", "Charles", "1800 160 401");
-    bistree_insert(contacts, c);
-
-    c = create_contact("Bellafonte", "Harry", "1300 975 707");
-    bistree_insert(contacts, c);
-
-    c = create_contact("Kelly", "Grace", "0491 578 888");
-    bistree_insert(contacts, c);
+    bistree_build_sorted(contacts, sorted, 5);
 }
 
 int compare_contacts_by_surname(const void* contact1, const void* contact2) {
@@ -47,20 +44,59 @@ int compare_contacts_by_surname(const void* contact1, const void* contact2) {
     return strcmp(c1->surname, c2->surname);
 }
 
+unsigned long long surname_prefix(const void* contact) {
+    return bistree_string_prefix(((const Contact*) contact)->surname);
+}
+
+int index_contact(const void* contact, void* index) {
+    return tst_insert(index, ((const Contact*) contact)->surname, contact) < 0;
+}
+
+int print_contact(const void* contact, void* count) {
+    const Contact* c = (const Contact*) contact;
+
+    printf("%s, %s: %s\n", c->surname, c->name, c->phone);
+    *(int*) count += 1;
+    return 0;
+}
+
 int main(void) {
     BisTree contacts;
+    Tst index;
     Contact* c;
-    int notfound;
+    int notfound, count;
     char surname[32];
 
     bistree_init(&contacts, compare_contacts_by_surname, free);
 
+    /* Most surnames differ in their first few letters, so strcmp is rarely needed */
+    bistree_set_prefix(&contacts, surname_prefix);
+
     build_contacts(&contacts);
 
-    printf("Surname to search for? ");
+    /* Index the surnames by character too, for type-ahead */
+    tst_init(&index, NULL);
+    if (bistree_range(&contacts, NULL, NULL, index_contact, &index)) {
+        fputs("Error indexing contacts!\n", stderr);
+        return 1;
+    }
+
+    printf("Surname to search for (end with * to match a prefix)? ");
     fgets(surname, sizeof(surname) - 1, stdin);
     surname[strlen(surname) - 1] = '\0'; // chop off trailing \n
 
+    if (strlen(surname) && surname[strlen(surname) - 1] == '*') {
+        /* Stream every contact whose surname starts with the prefix */
+        surname[strlen(surname) - 1] = '\0';
+        count = 0;
+        tst_prefix(&index, surname, print_contact, &count);
+        printf("%d found starting with \"%s\"\n", count, surname);
+
+        tst_destroy(&index);
+        bistree_destroy(&contacts);
+        return 0;
+    }
+
     c = create_contact(surname, NULL, NULL);
     notfound = bistree_lookup(&contacts, (void**) &c);
     if (notfound) {
@@ -0,0 +1,224 @@
+#include "../../include/bistree.h"
+#include "../../include/tst.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* Queries timed for each kind of lookup */
+#define QUERIES 200000
+
+/* Length of the prefixes typed ahead */
+#define TYPED 4
+
+/**
+ * @brief Order two strings
+ *
+ * @param key1 The first string
+ * @param key2 The second string
+ * @return Less than, equal to or greater than zero as strcmp.
+ */
+int compare_strings(const void* key1, const void* key2);
+
+/**
+ * @brief Pack the first bytes of a string into an integer that orders like it
+ *
+ * @param data The string
+ * @return The packed prefix.
+ */
+unsigned long long string_prefix(const void* data);
+
+/**
+ * @brief Count one match of a prefix query
+ *
+ * @param data The matching string
+ * @param count The number of matches so far
+ * @return 0 to keep going.
+ */
+int count_match(const void* data, void* count);
+
+/**
+ * @brief Make up a surname from random syllables
+ *
+ * @param name Filled with the surname, up to 16 letters long
+ * @param seed The generator state
+ */
+void make_name(char* name, unsigned int* seed);
+
+/**
+ * @brief Count the strings in a tree that start with a prefix, walking forwards from it
+ *
+ * @param tree The tree to search
+ * @param prefix The prefix
+ * @return The number of matches.
+ */
+int avl_prefix(const BisTree* tree, const char* prefix);
+
+/**
+ * @brief Convert a pair of times to nanoseconds per query
+ */
+double per_query(const struct timespec* begin, const struct timespec* end);
+
+int main(int argc, char* argv[]) {
+    struct timespec begin, end;
+    BisTree tree;
+    BisTree prefixed;
+    Tst index;
+    BisTreeStats stats;
+    char (*names)[24];
+    char prefix[TYPED + 1];
+    unsigned int seed;
+    void* data;
+    long avl_found, pre_found, tst_found, avl_matches, tst_matches;
+    int count, i, n;
+
+    count = argc > 1 ? atoi(argv[1]) : 200000;
+    if (count < 1) {
+        fputs("usage: typeahead [names]\n", stderr);
+        return 1;
+    }
+
+    names = malloc(count * sizeof(*names));
+    if (!names) {
+        fputs("Error allocating memory!\n", stderr);
+        return 1;
+    }
+
+    bistree_init(&tree, compare_strings, NULL);
+    bistree_init(&prefixed, compare_strings, NULL);
+    bistree_set_prefix(&prefixed, string_prefix);
+    tst_init(&index, NULL);
+
+    seed = 1;
+    for (i = 0; i < count; i++) {
+        make_name(names[i], &seed);
+
+        if (bistree_insert(&tree, names[i]) < 0 || bistree_insert(&prefixed, names[i]) < 0 ||
+            tst_insert(&index, names[i], names[i]) < 0) {
+            fputs("Error building index!\n", stderr);
+            return 1;
+        }
+    }
+
+    bistree_stats(&tree, &stats);
+    printf("%d distinct names, %zu bytes/name in bistree, %.1f in tst\n", stats.live, sizeof(AvlNode),
+           (double) index.count * sizeof(TstNode) / tst_size(&index));
+
+    /* Exact lookups of names known to be there */
+    avl_found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < QUERIES; i++) {
+        data = names[(i * 7919L) % count];
+        avl_found += !bistree_lookup(&tree, &data);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%-8s %-8s %10.1f ns\n", "exact", "bistree", per_query(&begin, &end));
+
+    /* The same tree comparing cached prefixes, which tie only past the 8th letter */
+    pre_found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < QUERIES; i++) {
+        data = names[(i * 7919L) % count];
+        pre_found += !bistree_lookup(&prefixed, &data);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%-8s %-8s %10.1f ns\n", "exact", "prefixed", per_query(&begin, &end));
+
+    tst_found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < QUERIES; i++) {
+        tst_found += !tst_lookup(&index, names[(i * 7919L) % count], &data);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%-8s %-8s %10.1f ns\n", "exact", "tst", per_query(&begin, &end));
+
+    /* Type-ahead on the first few letters of known names */
+    avl_matches = 0;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < QUERIES; i++) {
+        memcpy(prefix, names[(i * 7919L) % count], TYPED);
+        prefix[TYPED] = '\0';
+        avl_matches += avl_prefix(&tree, prefix);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%-8s %-8s %10.1f ns\n", "prefix", "bistree", per_query(&begin, &end));
+
+    tst_matches = 0;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < QUERIES; i++) {
+        memcpy(prefix, names[(i * 7919L) % count], TYPED);
+        prefix[TYPED] = '\0';
+        n = 0;
+        tst_prefix(&index, prefix, count_match, &n);
+        tst_matches += n;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%-8s %-8s %10.1f ns\n", "prefix", "tst", per_query(&begin, &end));
+
+    if (avl_found != tst_found || avl_found != pre_found || avl_matches != tst_matches) {
+        fputs("tst disagrees with the tree!\n", stderr);
+    }
+
+    printf("%.1f matches per prefix\n", (double) tst_matches / QUERIES);
+
+    tst_destroy(&index);
+    bistree_destroy(&prefixed);
+    bistree_destroy(&tree);
+    free(names);
+    return 0;
+}
+
+int compare_strings(const void* key1, const void* key2) {
+    return strcmp(key1, key2);
+}
+
+unsigned long long string_prefix(const void* data) {
+    return bistree_string_prefix(data);
+}
+
+int count_match(const void* data, void* count) {
+    (void) data;
+    *(int*) count += 1;
+    return 0;
+}
+
+void make_name(char* name, unsigned int* seed) {
+    static const char* onsets[] = { "b", "br", "c", "ch", "d", "f", "g", "h", "k", "l", "m", "n", "p", "r", "s", "st", "t", "w" };
+    static const char* vowels[] = { "a", "e", "i", "o", "u", "ai", "ea", "ou" };
+    int syllables, i;
+
+    /* Two to four syllables, the first capitalised */
+    name[0] = '\0';
+    *seed = *seed * 1103515245 + 12345;
+    syllables = 2 + (*seed >> 8) % 3;
+
+    for (i = 0; i < syllables; i++) {
+        *seed = *seed * 1103515245 + 12345;
+        strcat(name, onsets[(*seed >> 8) % 18]);
+        strcat(name, vowels[(*seed >> 16) % 8]);
+    }
+
+    name[0] -= 'a' - 'A';
+}
+
+int avl_prefix(const BisTree* tree, const char* prefix) {
+    BisCursor cursor;
+    size_t length;
+    int matches, retval;
+
+    length = strlen(prefix);
+    matches = 0;
+
+    for (retval = bistree_seek(tree, &cursor, prefix); !retval; retval = bistree_next(&cursor)) {
+        if (strncmp(bistree_cursor_data(&cursor), prefix, length) != 0) {
+            break;
+        }
+
+        matches++;
+    }
+
+    return matches;
+}
+
+double per_query(const struct timespec* begin, const struct timespec* end) {
+    return ((end->tv_sec - begin->tv_sec) * 1e9 + (end->tv_nsec - begin->tv_nsec)) / QUERIES;
+}
@@ -0,0 +1,224 @@
+#include "../../include/bistree.h"
+#include "../../include/splaytree.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Number of lookups in each trace */
+#define LOOKUPS 2000000
+
+/* Ranks counted as hot keys */
+#define HOT 256
+
+/* Comparisons made since the counter was last cleared */
+static long compares;
+
+/**
+ * @brief Order two integers stored directly in data pointers, counting each call
+ *
+ * @param key1 The first integer
+ * @param key2 The second integer
+ * @return -1, 0 or 1 as the first is less than, equal to or greater than the second.
+ */
+int compare_ints(const void* key1, const void* key2);
+
+/**
+ * @brief Draw a trace of keys whose ranks follow a Zipf distribution
+ *
+ * @param trace Filled with the keys to look up
+ * @param hot Filled with whether each lookup is of one of the HOT most frequent keys
+ * @param count The number of keys in the trees
+ * @param skew The Zipf exponent
+ * @return 0 on success or -1 on failure.
+ */
+int build_trace(void** trace, char* hot, int count, double skew);
+
+/**
+ * @brief Look up a whole trace in one tree & report its comparisons & time per lookup
+ *
+ * @param name The name of the tree
+ * @param lookup The tree's lookup function
+ * @param tree The tree to search
+ * @param trace The keys to look up
+ * @param hot Whether each lookup is of a hot key
+ */
+void measure(const char* name, int (*lookup)(void* tree, void** data), void* tree, void* const* trace,
+             const char* hot);
+
+/**
+ * @brief Call bistree_lookup through a common signature
+ */
+int avl_lookup(void* tree, void** data);
+
+/**
+ * @brief Call splaytree_lookup through a common signature
+ */
+int splay_lookup(void* tree, void** data);
+
+int main(int argc, char* argv[]) {
+    BisTree avl;
+    SplayTree splay;
+    void** items;
+    void** trace;
+    char* hot;
+    double skew;
+    int log2n, count, i;
+
+    log2n = argc > 1 ? atoi(argv[1]) : 20;
+    skew = argc > 2 ? atof(argv[2]) : 0.99;
+    if (log2n < 4 || log2n > 26 || skew <= 0.0) {
+        fputs("usage: zipf [log2 of size] [skew]\n", stderr);
+        return 1;
+    }
+
+    count = 1 << log2n;
+    items = malloc(count * sizeof(void*));
+    trace = malloc(LOOKUPS * sizeof(void*));
+    hot = malloc(LOOKUPS);
+    if (!items || !trace || !hot || build_trace(trace, hot, count, skew)) {
+        fputs("Error allocating memory!\n", stderr);
+        return 1;
+    }
+
+    /* Both trees hold the even numbers below twice the count */
+    for (i = 0; i < count; i++) {
+        items[i] = (void*) (intptr_t) (2 * i);
+    }
+
+    bistree_init(&avl, compare_ints, NULL);
+    splaytree_init(&splay, compare_ints, NULL);
+    if (bistree_build_sorted(&avl, items, count)) {
+        fputs("Error building tree!\n", stderr);
+        return 1;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (splaytree_insert(&splay, items[(int) ((i * 2654435761u) % (unsigned int) count)]) < 0) {
+            fputs("Error building tree!\n", stderr);
+            return 1;
+        }
+    }
+
+    printf("%d entries, Zipf(%.2f) trace of %d lookups\n", count, skew, LOOKUPS);
+    printf("%-8s %16s %16s %14s\n", "tree", "compares/lookup", "compares/hot", "ns/lookup");
+    measure("bistree", avl_lookup, &avl, trace, hot);
+    measure("splay", splay_lookup, &splay, trace, hot);
+
+    splaytree_destroy(&splay);
+    bistree_destroy(&avl);
+    free(items);
+    free(trace);
+    free(hot);
+    return 0;
+}
+
+int compare_ints(const void* key1, const void* key2) {
+    intptr_t k1 = (intptr_t) key1;
+    intptr_t k2 = (intptr_t) key2;
+
+    compares++;
+    return (k1 > k2) - (k1 < k2);
+}
+
+int build_trace(void** trace, char* hot, int count, double skew) {
+    double* cdf;
+    int* keys;
+    unsigned int seed;
+    double u;
+    int low, high, mid, i, j, tmp;
+
+    cdf = malloc(count * sizeof(double));
+    keys = malloc(count * sizeof(int));
+    if (!cdf || !keys) {
+        free(cdf);
+        free(keys);
+        return -1;
+    }
+
+    /* Give rank i a weight of 1 / i^skew */
+    for (i = 0; i < count; i++) {
+        cdf[i] = (i ? cdf[i - 1] : 0.0) + pow(i + 1, -skew);
+    }
+
+    /* Scatter the ranks over the keys so the hot ones are not neighbours */
+    seed = 1;
+    for (i = 0; i < count; i++) {
+        keys[i] = 2 * i;
+    }
+
+    for (i = count - 1; i > 0; i--) {
+        seed = seed * 1103515245 + 12345;
+        j = (seed >> 8) % (i + 1);
+        tmp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+
+    for (i = 0; i < LOOKUPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        u = (seed >> 8) / 16777216.0 * cdf[count - 1];
+
+        /* Find the first rank whose running weight passes u */
+        low = 0;
+        high = count - 1;
+        while (low < high) {
+            mid = (low + high) / 2;
+            if (cdf[mid] <= u) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+
+        trace[i] = (void*) (intptr_t) keys[low];
+        hot[i] = low < HOT;
+    }
+
+    free(cdf);
+    free(keys);
+    return 0;
+}
+
+void measure(const char* name, int (*lookup)(void* tree, void** data), void* tree, void* const* trace,
+             const char* hot) {
+    struct timespec begin, end;
+    void* data;
+    long missing, before, hot_compares, hot_lookups;
+    int i;
+
+    compares = 0;
+    missing = 0;
+    hot_compares = 0;
+    hot_lookups = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < LOOKUPS; i++) {
+        data = trace[i];
+        before = compares;
+        missing += lookup(tree, &data) != 0;
+
+        /* Hot lookups show the depth at which most hits are found */
+        if (hot[i]) {
+            hot_compares += compares - before;
+            hot_lookups++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (missing) {
+        fprintf(stderr, "%s missed %ld lookups!\n", name, missing);
+    }
+
+    printf("%-8s %16.2f %16.2f %14.1f\n", name, (double) compares / LOOKUPS,
+           hot_lookups ? (double) hot_compares / hot_lookups : 0.0, ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / LOOKUPS);
+}
+
+int avl_lookup(void* tree, void** data) {
+    return bistree_lookup(tree, data);
+}
+
+int splay_lookup(void* tree, void** data) {
+    return splaytree_lookup(tree, data);
+}
@@ -107,6 +107,7 @@ int graph_rem_vertex(Graph* graph, void** data) {
 
     /* Traverse each adjacency list & the vertices it contains */
     prev = NULL;
+    temp = NULL;
     found = 0;
 
     for (element = list_head(&graph->adjlists); element != NULL; element = list_next(element)) {
@@ -0,0 +1,231 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "../include/hyperanf.h"
+#include "../include/parallel.h"
+
+/* Vertices handed to a thread at a time */
+#define HYPERANF_GRAIN 512
+
+/* Doubles per per-thread accumulator, padded to a cache line */
+#define HYPERANF_STRIDE 8
+
+typedef struct {
+    const CsrGraph* csr;
+    int log2m;
+    unsigned char* cur;
+    unsigned char* next;
+    double* reach;
+    double* sums;
+    int* changed;
+    double powers[66];
+} Anf;
+
+static uint64_t hash_vertex(uint64_t v) {
+    /* splitmix64 finalizer */
+    v += 0x9e3779b97f4a7c15ULL;
+    v = (v ^ (v >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    v = (v ^ (v >> 27)) * 0x94d049bb133111ebULL;
+    return v ^ (v >> 31);
+}
+
+static double estimate(const unsigned char* registers, int log2m, const double* powers) {
+    double m, sum, alpha, result;
+    int zeros, j;
+
+    m = (double) (1 << log2m);
+    sum = 0.0;
+    zeros = 0;
+
+    for (j = 0; j < (1 << log2m); j++) {
+        sum += powers[registers[j]];
+        zeros += !registers[j];
+    }
+
+    switch (log2m) {
+        case 4:
+            alpha = 0.673;
+            break;
+
+        case 5:
+            alpha = 0.697;
+            break;
+
+        case 6:
+            alpha = 0.709;
+            break;
+
+        default:
+            alpha = 0.7213 / (1.0 + 1.079 / m);
+            break;
+    }
+
+    result = alpha * m * m / sum;
+
+    /* Small cardinalities are better served by linear counting */
+    if (result <= 2.5 * m && zeros) {
+        result = m * log(m / zeros);
+    }
+
+    return result;
+}
+
+static void merge(unsigned char* into, const unsigned char* from, int m) {
+    int j;
+
+#ifdef __SSE2__
+    /* Take the register-wise maximum sixteen registers at a time */
+    for (j = 0; j + 16 <= m; j += 16) {
+        _mm_storeu_si128((__m128i*) (into + j),
+                         _mm_max_epu8(_mm_loadu_si128((const __m128i*) (into + j)),
+                                      _mm_loadu_si128((const __m128i*) (from + j))));
+    }
+#else
+    j = 0;
+#endif
+
+    for (; j < m; j++) {
+        if (from[j] > into[j]) {
+            into[j] = from[j];
+        }
+    }
+}
+
+static void iterate(int begin, int end, int thread, void* arg) {
+    const Anf* anf = arg;
+    const int* adj;
+    unsigned char* counter;
+    double sum;
+    size_t m;
+    int v, i;
+
+    m = (size_t) 1 << anf->log2m;
+    sum = 0.0;
+
+    /* A vertex reaches itself plus whatever its out-neighbours reached */
+    for (v = begin; v < end; v++) {
+        counter = anf->next + v * m;
+        memcpy(counter, anf->cur + v * m, m);
+
+        adj = csr_neighbours(anf->csr, v);
+        for (i = 0; i < csr_degree(anf->csr, v); i++) {
+            merge(counter, anf->cur + adj[i] * m, (int) m);
+        }
+
+        /* An unchanged counter keeps its last estimate */
+        if (memcmp(counter, anf->cur + v * m, m)) {
+            anf->changed[thread * HYPERANF_STRIDE] = 1;
+            anf->reach[v] = estimate(counter, anf->log2m, anf->powers);
+        }
+
+        sum += anf->reach[v];
+    }
+
+    anf->sums[thread * HYPERANF_STRIDE] += sum;
+}
+
+int hyperanf_log2m(double error) {
+    int log2m;
+
+    /* The relative standard error of HyperLogLog is 1.04 / sqrt(m) */
+    for (log2m = HYPERANF_MIN_LOG2M; log2m < HYPERANF_MAX_LOG2M; log2m++) {
+        if (1.04 / sqrt((double) (1 << log2m)) <= error) {
+            break;
+        }
+    }
+
+    return log2m;
+}
+
+int hyperanf(const CsrGraph* csr, int log2m, int maxhops, int nthreads, double* nf, double* reach) {
+    unsigned char* swap;
+    int* changed;
+    double* estimates;
+    uint64_t hash;
+    size_t m;
+    Anf anf;
+    int rank, hops, any, v, t;
+
+    if (log2m < HYPERANF_MIN_LOG2M || log2m > HYPERANF_MAX_LOG2M || maxhops < 0) {
+        return -1;
+    }
+
+    nthreads = parallel_threads(nthreads);
+    m = (size_t) 1 << log2m;
+
+    anf.csr = csr;
+    anf.log2m = log2m;
+    anf.cur = calloc((size_t) csr_vcount(csr) * m + 1, 1);
+    anf.next = malloc((size_t) csr_vcount(csr) * m + 1);
+    estimates = reach ? reach : malloc((csr_vcount(csr) + 1) * sizeof(double));
+    anf.sums = calloc((size_t) nthreads * HYPERANF_STRIDE, sizeof(double));
+    changed = calloc((size_t) nthreads * HYPERANF_STRIDE, sizeof(int));
+    anf.reach = estimates;
+    anf.changed = changed;
+
+    if (!anf.cur || !anf.next || !estimates || !anf.sums || !changed) {
+        free(anf.cur);
+        free(anf.next);
+        if (!reach) {
+            free(estimates);
+        }
+        free(anf.sums);
+        free(changed);
+        return -1;
+    }
+
+    /* Registers never exceed 64 - log2m + 1, so a small table covers every 2^-k */
+    for (v = 0; v < 66; v++) {
+        anf.powers[v] = ldexp(1.0, -v);
+    }
+
+    /* Start each counter off holding just its own vertex */
+    for (v = 0; v < csr_vcount(csr); v++) {
+        hash = hash_vertex((uint64_t) v);
+        rank = (hash << log2m) ? __builtin_clzll(hash << log2m) + 1 : 64 - log2m + 1;
+        anf.cur[v * m + (hash >> (64 - log2m))] = (unsigned char) rank;
+        estimates[v] = 1.0;
+    }
+
+    nf[0] = csr_vcount(csr);
+
+    /* Union neighbour counters one hop at a time until nothing changes */
+    for (hops = 1; hops <= maxhops; hops++) {
+        parallel_for(csr_vcount(csr), HYPERANF_GRAIN, nthreads, iterate, &anf);
+
+        nf[hops] = 0.0;
+        any = 0;
+        for (t = 0; t < nthreads; t++) {
+            nf[hops] += anf.sums[t * HYPERANF_STRIDE];
+            any |= changed[t * HYPERANF_STRIDE];
+            anf.sums[t * HYPERANF_STRIDE] = 0.0;
+            changed[t * HYPERANF_STRIDE] = 0;
+        }
+
+        swap = anf.cur;
+        anf.cur = anf.next;
+        anf.next = swap;
+
+        if (!any) {
+            break;
+        }
+    }
+
+    /* The function stays flat once every counter has stopped growing */
+    for (t = hops + 1; t <= maxhops; t++) {
+        nf[t] = nf[hops];
+    }
+
+    free(anf.cur);
+    free(anf.next);
+    if (!reach) {
+        free(estimates);
+    }
+    free(anf.sums);
+    free(changed);
+
+    return hops > maxhops ? maxhops : hops;
+}
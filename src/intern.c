@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/intern.h"
+
+/* Initial number of buckets, always a power of two */
+#define INTERN_BUCKETS 64
+
+static unsigned int hash_name(const char* name) {
+    unsigned int hash = 2166136261u;
+
+    /* FNV-1a */
+    while (*name) {
+        hash = (hash ^ (unsigned char) *name++) * 16777619u;
+    }
+
+    return hash;
+}
+
+static int find_bucket(const InternTable* table, const char* name, unsigned int hash) {
+    int bucket, id;
+
+    /* Probe linearly; buckets hold id + 1 so that 0 marks an empty one */
+    bucket = hash & (table->nbuckets - 1);
+    while ((id = table->buckets[bucket] - 1) >= 0) {
+        if (table->hashes[id] == hash && strcmp(table->names[id], name) == 0) {
+            break;
+        }
+
+        bucket = (bucket + 1) & (table->nbuckets - 1);
+    }
+
+    return bucket;
+}
+
+static int grow(InternTable* table) {
+    unsigned int* hashes;
+    char** names;
+    int* buckets;
+    int capacity, bucket, id;
+
+    if (table->size == table->capacity) {
+        capacity = 2 * table->capacity;
+        names = realloc(table->names, capacity * sizeof(char*));
+        if (!names) {
+            return -1;
+        }
+
+        table->names = names;
+        hashes = realloc(table->hashes, capacity * sizeof(unsigned int));
+        if (!hashes) {
+            return -1;
+        }
+
+        table->hashes = hashes;
+        table->capacity = capacity;
+    }
+
+    /* Keep the load factor at or below a half */
+    if (2 * (table->size + 1) > table->nbuckets) {
+        buckets = calloc(2 * table->nbuckets, sizeof(int));
+        if (!buckets) {
+            return -1;
+        }
+
+        free(table->buckets);
+        table->buckets = buckets;
+        table->nbuckets *= 2;
+
+        for (id = 0; id < table->size; id++) {
+            bucket = table->hashes[id] & (table->nbuckets - 1);
+            while (table->buckets[bucket]) {
+                bucket = (bucket + 1) & (table->nbuckets - 1);
+            }
+
+            table->buckets[bucket] = id + 1;
+        }
+    }
+
+    return 0;
+}
+
+int intern_init(InternTable* table) {
+    table->size = 0;
+    table->capacity = INTERN_BUCKETS / 2;
+    table->nbuckets = INTERN_BUCKETS;
+    table->buckets = calloc(table->nbuckets, sizeof(int));
+    table->hashes = malloc(table->capacity * sizeof(unsigned int));
+    table->names = malloc(table->capacity * sizeof(char*));
+
+    if (!table->buckets || !table->hashes || !table->names) {
+        intern_destroy(table);
+        return -1;
+    }
+
+    return 0;
+}
+
+void intern_destroy(InternTable* table) {
+    int id;
+
+    for (id = 0; table->names && id < table->size; id++) {
+        free(table->names[id]);
+    }
+
+    free(table->buckets);
+    free(table->hashes);
+    free(table->names);
+    memset(table, 0, sizeof(InternTable));
+}
+
+int intern_id(InternTable* table, const char* name) {
+    unsigned int hash;
+    size_t length;
+    int bucket;
+
+    hash = hash_name(name);
+    bucket = find_bucket(table, name, hash);
+
+    /* A name seen before keeps the id it was first given */
+    if (table->buckets[bucket]) {
+        return table->buckets[bucket] - 1;
+    }
+
+    if (grow(table)) {
+        return -1;
+    }
+
+    length = strlen(name) + 1;
+    table->names[table->size] = malloc(length);
+    if (!table->names[table->size]) {
+        return -1;
+    }
+
+    memcpy(table->names[table->size], name, length);
+    table->hashes[table->size] = hash;
+
+    /* Growing may have moved the buckets, so probe again */
+    bucket = find_bucket(table, name, hash);
+    table->buckets[bucket] = table->size + 1;
+
+    return table->size++;
+}
+
+int intern_lookup(const InternTable* table, const char* name) {
+    return table->buckets[find_bucket(table, name, hash_name(name))] - 1;
+}
@@ -0,0 +1,295 @@
+#include <math.h>
+#include <string.h>
+#include "../include/pagerank.h"
+#include "../include/parallel.h"
+
+/* Vertices handed to a thread at a time */
+#define PAGERANK_GRAIN 1024
+
+/* Doubles per per-thread accumulator, padded to a cache line */
+#define PAGERANK_STRIDE 8
+
+typedef struct {
+    const CsrGraph* csr;
+    const double* x;
+    double* y;
+    double* partial;
+    int nthreads;
+    ParallelPool* pool;
+} Spmv;
+
+typedef struct {
+    const CsrGraph* csr;
+    double* rank;
+    double* contrib;
+    double* y;
+    double* sums;
+    double base;
+    double damping;
+} Step;
+
+static void pull_rows(int begin, int end, int thread, void* arg) {
+    const Spmv* spmv = arg;
+    const int* adj;
+    double sum;
+    int v, i;
+
+    (void) thread;
+
+    /* Each row gathers from its in-neighbours, so no writes are shared */
+    for (v = begin; v < end; v++) {
+        adj = csr_neighbours(spmv->csr, v);
+        sum = 0.0;
+
+        for (i = 0; i < csr_degree(spmv->csr, v); i++) {
+            sum += spmv->x[adj[i]];
+        }
+
+        spmv->y[v] = sum;
+    }
+}
+
+static void push_rows(int begin, int end, int thread, void* arg) {
+    const Spmv* spmv = arg;
+    const int* adj;
+    double* y;
+    double xu;
+    int u, i;
+
+    /* Scatter into this thread's own copy of y */
+    y = spmv->partial + (size_t) thread * csr_vcount(spmv->csr);
+
+    for (u = begin; u < end; u++) {
+        adj = csr_neighbours(spmv->csr, u);
+        xu = spmv->x[u];
+
+        for (i = 0; i < csr_degree(spmv->csr, u); i++) {
+            y[adj[i]] += xu;
+        }
+    }
+}
+
+static void clear_partials(int begin, int end, int thread, void* arg) {
+    const Spmv* spmv = arg;
+    size_t vcount;
+    int t;
+
+    (void) thread;
+    vcount = csr_vcount(spmv->csr);
+
+    for (t = 0; t < spmv->nthreads; t++) {
+        memset(spmv->partial + t * vcount + begin, 0, (end - begin) * sizeof(double));
+    }
+}
+
+static void reduce_partials(int begin, int end, int thread, void* arg) {
+    const Spmv* spmv = arg;
+    size_t vcount;
+    int v, t;
+
+    (void) thread;
+    vcount = csr_vcount(spmv->csr);
+
+    for (v = begin; v < end; v++) {
+        spmv->y[v] = spmv->partial[v];
+    }
+
+    for (t = 1; t < spmv->nthreads; t++) {
+        for (v = begin; v < end; v++) {
+            spmv->y[v] += spmv->partial[t * vcount + v];
+        }
+    }
+}
+
+static void push_with(Spmv* spmv) {
+    int vcount = csr_vcount(spmv->csr);
+
+    parallel_pool_for(spmv->pool, vcount, PAGERANK_GRAIN, clear_partials, spmv);
+    parallel_pool_for(spmv->pool, vcount, PAGERANK_GRAIN, push_rows, spmv);
+    parallel_pool_for(spmv->pool, vcount, PAGERANK_GRAIN, reduce_partials, spmv);
+}
+
+int spmv_pull(const CsrGraph* transposed, const double* x, double* y, int nthreads) {
+    Spmv spmv;
+
+    spmv.csr = transposed;
+    spmv.x = x;
+    spmv.y = y;
+    spmv.partial = NULL;
+    spmv.nthreads = parallel_threads(nthreads);
+    spmv.pool = NULL;
+
+    parallel_for(csr_vcount(transposed), PAGERANK_GRAIN, spmv.nthreads, pull_rows, &spmv);
+    return 0;
+}
+
+int spmv_push(const CsrGraph* csr, const double* x, double* y, int nthreads) {
+    ParallelPool pool;
+    Spmv spmv;
+
+    spmv.csr = csr;
+    spmv.x = x;
+    spmv.y = y;
+    spmv.nthreads = parallel_threads(nthreads);
+    spmv.partial = malloc((size_t) spmv.nthreads * (csr_vcount(csr) ? csr_vcount(csr) : 1) * sizeof(double));
+    if (!spmv.partial) {
+        return -1;
+    }
+
+    /* Clearing, scattering & reducing share one set of threads */
+    if (parallel_pool_init(&pool, spmv.nthreads)) {
+        free(spmv.partial);
+        return -1;
+    }
+
+    spmv.pool = &pool;
+    push_with(&spmv);
+
+    parallel_pool_destroy(&pool);
+    free(spmv.partial);
+    return 0;
+}
+
+static void prepare(int begin, int end, int thread, void* arg) {
+    const Step* step = arg;
+    double dangling;
+    int u;
+
+    /* Spread each rank over the out-edges, pooling what dangling vertices hold */
+    dangling = 0.0;
+    for (u = begin; u < end; u++) {
+        if (csr_degree(step->csr, u)) {
+            step->contrib[u] = step->rank[u] / csr_degree(step->csr, u);
+        }
+        else {
+            step->contrib[u] = 0.0;
+            dangling += step->rank[u];
+        }
+    }
+
+    step->sums[thread * PAGERANK_STRIDE] += dangling;
+}
+
+static void update(int begin, int end, int thread, void* arg) {
+    const Step* step = arg;
+    double error, rank;
+    int v;
+
+    error = 0.0;
+    for (v = begin; v < end; v++) {
+        rank = step->base + step->damping * step->y[v];
+        error += fabs(rank - step->rank[v]);
+        step->rank[v] = rank;
+    }
+
+    step->sums[thread * PAGERANK_STRIDE] += error;
+}
+
+static double collect(double* sums, int nthreads) {
+    double total;
+    int t;
+
+    total = 0.0;
+    for (t = 0; t < nthreads; t++) {
+        total += sums[t * PAGERANK_STRIDE];
+        sums[t * PAGERANK_STRIDE] = 0.0;
+    }
+
+    return total;
+}
+
+int pagerank(const CsrGraph* csr, double damping, double tolerance, int maxiter,
+             PageRankMode mode, int nthreads, double* rank) {
+    CsrGraph transposed;
+    ParallelPool pool;
+    Spmv spmv;
+    Step step;
+    double* sums;
+    double dangling, error;
+    int vcount, iter, v;
+
+    if (mode != PAGERANK_PULL && mode != PAGERANK_PUSH) {
+        return -1;
+    }
+
+    vcount = csr_vcount(csr);
+    if (!vcount) {
+        return 0;
+    }
+
+    nthreads = parallel_threads(nthreads);
+
+    if (mode == PAGERANK_PULL && csr_transpose(&transposed, csr)) {
+        return -1;
+    }
+
+    /* Start the threads once, rather than for each of the loops in every iteration */
+    if (parallel_pool_init(&pool, nthreads)) {
+        if (mode == PAGERANK_PULL) {
+            csr_destroy(&transposed);
+        }
+
+        return -1;
+    }
+
+    step.csr = csr;
+    step.rank = rank;
+    step.damping = damping;
+    step.contrib = malloc(vcount * sizeof(double));
+    step.y = malloc(vcount * sizeof(double));
+    sums = calloc((size_t) nthreads * PAGERANK_STRIDE, sizeof(double));
+    step.sums = sums;
+
+    spmv.csr = mode == PAGERANK_PULL ? &transposed : csr;
+    spmv.x = step.contrib;
+    spmv.y = step.y;
+    spmv.nthreads = nthreads;
+    spmv.pool = &pool;
+    spmv.partial = mode == PAGERANK_PUSH ? malloc((size_t) nthreads * vcount * sizeof(double)) : NULL;
+
+    if (!step.contrib || !step.y || !sums || (mode == PAGERANK_PUSH && !spmv.partial)) {
+        iter = -1;
+    }
+    else {
+        for (v = 0; v < vcount; v++) {
+            rank[v] = 1.0 / vcount;
+        }
+
+        /* Iterate until the ranks move less than the tolerance in total */
+        for (iter = 1; iter <= maxiter; iter++) {
+            parallel_pool_for(&pool, vcount, PAGERANK_GRAIN, prepare, &step);
+            dangling = collect(sums, nthreads);
+
+            if (mode == PAGERANK_PULL) {
+                parallel_pool_for(&pool, vcount, PAGERANK_GRAIN, pull_rows, &spmv);
+            }
+            else {
+                push_with(&spmv);
+            }
+
+            step.base = (1.0 - damping) / vcount + damping * dangling / vcount;
+            parallel_pool_for(&pool, vcount, PAGERANK_GRAIN, update, &step);
+            error = collect(sums, nthreads);
+
+            if (error < tolerance) {
+                break;
+            }
+        }
+
+        if (iter > maxiter) {
+            iter = maxiter;
+        }
+    }
+
+    parallel_pool_destroy(&pool);
+
+    if (mode == PAGERANK_PULL) {
+        csr_destroy(&transposed);
+    }
+
+    free(step.contrib);
+    free(step.y);
+    free(sums);
+    free(spmv.partial);
+    return iter;
+}
@@ -0,0 +1,195 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../include/parallel.h"
+
+/* Upper bound on worker threads for one loop */
+#define PARALLEL_MAX_THREADS 256
+
+static void* run_worker(void* data) {
+    ParallelWorker* worker = data;
+    ParallelLoop* loop = worker->loop;
+    int begin, end;
+
+    /* Claim chunks of the iteration space until it is exhausted */
+    for (;;) {
+        begin = atomic_fetch_add(&loop->next, loop->grain);
+        if (begin >= loop->n) {
+            break;
+        }
+
+        end = begin + loop->grain < loop->n ? begin + loop->grain : loop->n;
+        loop->body(begin, end, worker->thread, loop->arg);
+    }
+
+    return NULL;
+}
+
+static void* run_pooled(void* data) {
+    ParallelWorker* worker = data;
+    ParallelPool* pool = worker->pool;
+    unsigned long seen;
+
+    seen = 0;
+    pthread_mutex_lock(&pool->lock);
+
+    /* Sleep until a new loop is posted, run our share, then report back */
+    for (;;) {
+        while (pool->generation == seen && !pool->stop) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+
+        if (pool->stop) {
+            break;
+        }
+
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_worker(worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int parallel_threads(int nthreads) {
+    long online;
+
+    if (nthreads > 0) {
+        return nthreads < PARALLEL_MAX_THREADS ? nthreads : PARALLEL_MAX_THREADS;
+    }
+
+    /* Default to one thread per online processor */
+    online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) {
+        return 1;
+    }
+
+    return online < PARALLEL_MAX_THREADS ? (int) online : PARALLEL_MAX_THREADS;
+}
+
+int parallel_for(int n, int grain, int nthreads,
+                 void (*body)(int begin, int end, int thread, void* arg), void* arg) {
+    pthread_t threads[PARALLEL_MAX_THREADS];
+    ParallelWorker workers[PARALLEL_MAX_THREADS];
+    ParallelLoop loop;
+    int started, i;
+
+    nthreads = parallel_threads(nthreads);
+
+    loop.n = n;
+    loop.grain = grain > 0 ? grain : 1;
+    loop.body = body;
+    loop.arg = arg;
+    atomic_init(&loop.next, 0);
+
+    /* The calling thread works as thread 0 & finishes whatever is left */
+    for (started = 1; started < nthreads; started++) {
+        workers[started].loop = &loop;
+        workers[started].thread = started;
+        workers[started].pool = NULL;
+
+        if (pthread_create(&threads[started], NULL, run_worker, &workers[started])) {
+            break;
+        }
+    }
+
+    workers[0].loop = &loop;
+    workers[0].thread = 0;
+    workers[0].pool = NULL;
+    run_worker(&workers[0]);
+
+    for (i = 1; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Pass back how many threads took part */
+    return started;
+}
+
+int parallel_pool_init(ParallelPool* pool, int nthreads) {
+    int started;
+
+    nthreads = parallel_threads(nthreads);
+
+    pool->active = 0;
+    pool->stop = 0;
+    pool->generation = 0;
+    pool->threads = malloc(nthreads * sizeof(pthread_t));
+    pool->workers = malloc(nthreads * sizeof(ParallelWorker));
+    if (!pool->threads || !pool->workers) {
+        free(pool->threads);
+        free(pool->workers);
+        return -1;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (started = 0; started < nthreads; started++) {
+        pool->workers[started].loop = &pool->loop;
+        pool->workers[started].thread = started;
+        pool->workers[started].pool = pool;
+    }
+
+    /* The calling thread works as thread 0, so start one fewer */
+    for (started = 1; started < nthreads; started++) {
+        if (pthread_create(&pool->threads[started], NULL, run_pooled, &pool->workers[started])) {
+            break;
+        }
+    }
+
+    pool->nthreads = started;
+    return 0;
+}
+
+void parallel_pool_destroy(ParallelPool* pool) {
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 1; i < pool->nthreads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool->workers);
+}
+
+void parallel_pool_for(ParallelPool* pool, int n, int grain,
+                       void (*body)(int begin, int end, int thread, void* arg), void* arg) {
+    pool->loop.n = n;
+    pool->loop.grain = grain > 0 ? grain : 1;
+    pool->loop.body = body;
+    pool->loop.arg = arg;
+    atomic_init(&pool->loop.next, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->active = pool->nthreads - 1;
+    pool->generation += 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_worker(&pool->workers[0]);
+
+    /* Wait for every worker to finish before the loop state is reused */
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
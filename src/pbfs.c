@@ -0,0 +1,298 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../include/pbfs.h"
+
+/* Header of the region shared by the worker processes */
+typedef struct {
+    pthread_barrier_t barrier;
+    int failed;
+} PbfsShared;
+
+/* Where each piece of the search lives, fixed before the workers fork */
+typedef struct {
+    const CsrGraph* csr;
+    PbfsPartition partition;
+    int nparts;
+    int chunk;
+    int start;
+    int base[PBFS_MAX_PARTS + 1];
+    PbfsShared* shared;
+    int* sizes;
+    int* counts;
+    int* hops;
+    int* queues;
+    PbfsLevel* levels;
+} Pbfs;
+
+static int owner(const Pbfs* pbfs, int v) {
+    if (pbfs->partition == PBFS_RANGE) {
+        return v / pbfs->chunk;
+    }
+
+    /* Scatter neighbouring ids using the top bits of a multiplicative hash */
+    return (int) (((unsigned long long) ((unsigned int) v * 2654435761u) * pbfs->nparts) >> 32);
+}
+
+static void add_level(PbfsLevel* level, long frontier, long edges, long messages) {
+    __atomic_fetch_add(&level->frontier, frontier, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&level->edges, edges, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&level->messages, messages, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&level->bytes, messages * (long) sizeof(int), __ATOMIC_RELAXED);
+}
+
+static int work(Pbfs* pbfs, int part) {
+    const CsrGraph* csr = pbfs->csr;
+    unsigned char* sent;
+    int* frontier;
+    int* next;
+    int* swap;
+    int* queue;
+    const int* adj;
+    long edges, messages;
+    int size, nsize, total, level, dest, u, w, q, i, j;
+
+    /* Each process keeps its own frontier & a note of the remote vertices it has sent */
+    frontier = malloc((csr_vcount(csr) + 1) * sizeof(int));
+    next = malloc((csr_vcount(csr) + 1) * sizeof(int));
+    sent = calloc(csr_vcount(csr) + 1, 1);
+
+    if (!frontier || !next || !sent) {
+        __atomic_store_n(&pbfs->shared->failed, 1, __ATOMIC_RELAXED);
+    }
+
+    pthread_barrier_wait(&pbfs->shared->barrier);
+    if (__atomic_load_n(&pbfs->shared->failed, __ATOMIC_RELAXED)) {
+        free(frontier);
+        free(next);
+        free(sent);
+        return -1;
+    }
+
+    size = 0;
+    if (owner(pbfs, pbfs->start) == part) {
+        frontier[size++] = pbfs->start;
+    }
+
+    for (level = 0;; level++) {
+        nsize = 0;
+        edges = messages = 0;
+
+        /* Expand the local frontier, queueing remote neighbours for their owners */
+        for (i = 0; i < size; i++) {
+            u = frontier[i];
+            adj = csr_neighbours(csr, u);
+            edges += csr_degree(csr, u);
+
+            for (j = 0; j < csr_degree(csr, u); j++) {
+                w = adj[j];
+                dest = owner(pbfs, w);
+
+                if (dest == part) {
+                    if (pbfs->hops[w] < 0) {
+                        pbfs->hops[w] = level + 1;
+                        next[nsize++] = w;
+                    }
+                }
+                else if (!sent[w]) {
+                    sent[w] = 1;
+                    q = part * pbfs->nparts + dest;
+                    pbfs->queues[part * csr_vcount(csr) + pbfs->base[dest] + pbfs->counts[q]++] = w;
+                    messages += 1;
+                }
+            }
+        }
+
+        pthread_barrier_wait(&pbfs->shared->barrier);
+
+        /* Drain what the other partitions sent this way */
+        for (i = 0; i < pbfs->nparts; i++) {
+            q = i * pbfs->nparts + part;
+            queue = pbfs->queues + i * csr_vcount(csr) + pbfs->base[part];
+
+            for (j = 0; j < pbfs->counts[q]; j++) {
+                if (pbfs->hops[queue[j]] < 0) {
+                    pbfs->hops[queue[j]] = level + 1;
+                    next[nsize++] = queue[j];
+                }
+            }
+
+            pbfs->counts[q] = 0;
+        }
+
+        add_level(&pbfs->levels[level], size, edges, messages);
+        pbfs->sizes[part] = nsize;
+        pthread_barrier_wait(&pbfs->shared->barrier);
+
+        /* Every process sees the same sizes, so all agree on when to stop */
+        total = 0;
+        for (i = 0; i < pbfs->nparts; i++) {
+            total += pbfs->sizes[i];
+        }
+
+        if (!total) {
+            break;
+        }
+
+        swap = frontier;
+        frontier = next;
+        next = swap;
+        size = nsize;
+    }
+
+    free(frontier);
+    free(next);
+    free(sent);
+    return 0;
+}
+
+static size_t align(size_t size) {
+    return (size + 63) & ~(size_t) 63;
+}
+
+int pbfs(const CsrGraph* csr, int start, int nparts, PbfsPartition partition, int* hops, PbfsStats* stats) {
+    pthread_barrierattr_t attr;
+    pid_t pids[PBFS_MAX_PARTS];
+    char name[64];
+    size_t length, offset;
+    char* region;
+    Pbfs pbfs;
+    int fd, status, rc, nlevels, p, v;
+
+    if (start < 0 || start >= csr_vcount(csr) || nparts < 1 || nparts > PBFS_MAX_PARTS) {
+        return -1;
+    }
+
+    pbfs.csr = csr;
+    pbfs.partition = partition;
+    pbfs.nparts = nparts;
+    pbfs.chunk = (csr_vcount(csr) + nparts - 1) / nparts;
+    pbfs.start = start;
+
+    /* Find where each partition's slots begin in a sender's block of queues */
+    memset(pbfs.base, 0, sizeof(pbfs.base));
+    for (v = 0; v < csr_vcount(csr); v++) {
+        pbfs.base[owner(&pbfs, v) + 1] += 1;
+    }
+
+    for (p = 0; p < nparts; p++) {
+        pbfs.base[p + 1] += pbfs.base[p];
+    }
+
+    /* A sender never queues the same vertex twice, so each queue fits its owner's vertices */
+    length = align(sizeof(PbfsShared)) + align(nparts * sizeof(int)) + align(nparts * nparts * sizeof(int))
+             + align(csr_vcount(csr) * sizeof(int)) + align((size_t) nparts * csr_vcount(csr) * sizeof(int))
+             + (csr_vcount(csr) + 1) * sizeof(PbfsLevel);
+
+    snprintf(name, sizeof(name), "/pbfs-%ld", (long) getpid());
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+
+    /* The name is only needed until the workers have inherited the mapping */
+    shm_unlink(name);
+
+    if (ftruncate(fd, length)) {
+        close(fd);
+        return -1;
+    }
+
+    region = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        return -1;
+    }
+
+    offset = 0;
+    pbfs.shared = (PbfsShared*) region;
+    offset += align(sizeof(PbfsShared));
+    pbfs.sizes = (int*) (region + offset);
+    offset += align(nparts * sizeof(int));
+    pbfs.counts = (int*) (region + offset);
+    offset += align(nparts * nparts * sizeof(int));
+    pbfs.hops = (int*) (region + offset);
+    offset += align(csr_vcount(csr) * sizeof(int));
+    pbfs.queues = (int*) (region + offset);
+    offset += align((size_t) nparts * csr_vcount(csr) * sizeof(int));
+    pbfs.levels = (PbfsLevel*) (region + offset);
+
+    for (v = 0; v < csr_vcount(csr); v++) {
+        pbfs.hops[v] = -1;
+    }
+
+    pbfs.hops[start] = 0;
+
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    rc = pthread_barrier_init(&pbfs.shared->barrier, &attr, nparts);
+    pthread_barrierattr_destroy(&attr);
+
+    if (rc) {
+        munmap(region, length);
+        return -1;
+    }
+
+    /* Serve each partition from its own process */
+    rc = 0;
+    for (p = 0; p < nparts; p++) {
+        pids[p] = fork();
+
+        if (pids[p] == 0) {
+            _exit(work(&pbfs, p) ? 1 : 0);
+        }
+        else if (pids[p] < 0) {
+            /* Workers already started would wait at the barrier forever */
+            while (--p >= 0) {
+                kill(pids[p], SIGKILL);
+                waitpid(pids[p], NULL, 0);
+            }
+
+            pthread_barrier_destroy(&pbfs.shared->barrier);
+            munmap(region, length);
+            return -1;
+        }
+    }
+
+    for (p = 0; p < nparts; p++) {
+        if (waitpid(pids[p], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+            rc = -1;
+        }
+    }
+
+    if (!rc) {
+        memcpy(hops, pbfs.hops, csr_vcount(csr) * sizeof(int));
+
+        nlevels = 0;
+        while (nlevels <= csr_vcount(csr) && pbfs.levels[nlevels].frontier) {
+            nlevels += 1;
+        }
+
+        if (stats) {
+            stats->nparts = nparts;
+            stats->nlevels = nlevels;
+            stats->levels = malloc((nlevels + 1) * sizeof(PbfsLevel));
+
+            if (stats->levels) {
+                memcpy(stats->levels, pbfs.levels, nlevels * sizeof(PbfsLevel));
+            }
+            else {
+                rc = -1;
+            }
+        }
+    }
+
+    pthread_barrier_destroy(&pbfs.shared->barrier);
+    munmap(region, length);
+    return rc;
+}
+
+void pbfs_stats_destroy(PbfsStats* stats) {
+    free(stats->levels);
+    memset(stats, 0, sizeof(PbfsStats));
+}
@@ -0,0 +1,347 @@
+#include <string.h>
+#include "../include/pbistree.h"
+
+/* Nodes replaced by one update, retired together */
+typedef struct {
+    int count;
+    const PbisNode* nodes[];
+} PbisGarbage;
+
+static int height(const PbisNode* node) {
+    return node ? node->height : 0;
+}
+
+static const PbisNode* new_node(PbisTree* tree, const void* data, const PbisNode* left, const PbisNode* right) {
+    PbisNode* node;
+
+    if (tree->ncreated == PBISTREE_SCRATCH) {
+        return NULL;
+    }
+
+    node = (PbisNode*) malloc(sizeof(PbisNode));
+    if (!node) {
+        return NULL;
+    }
+
+    node->data = (void*) data;
+    node->left = left;
+    node->right = right;
+    node->height = (height(left) > height(right) ? height(left) : height(right)) + 1;
+
+    tree->created[tree->ncreated++] = node;
+    return node;
+}
+
+static void replace(PbisTree* tree, const PbisNode* node) {
+    /* Older versions may still be reading the node, so it goes only once they are done */
+    tree->replaced[tree->nreplaced++] = node;
+}
+
+static const PbisNode* balance(PbisTree* tree, const void* data, const PbisNode* left, const PbisNode* right) {
+    const PbisNode* inner;
+    const PbisNode* outer;
+
+    if (height(left) > height(right) + 1) {
+        if (height(left->left) >= height(left->right)) {
+            /* Perform an LL rotation */
+            replace(tree, left);
+            inner = new_node(tree, data, left->right, right);
+            return inner ? new_node(tree, left->data, left->left, inner) : NULL;
+        }
+
+        /* Perform an LR rotation */
+        replace(tree, left);
+        replace(tree, left->right);
+        outer = new_node(tree, left->data, left->left, left->right->left);
+        inner = new_node(tree, data, left->right->right, right);
+        return outer && inner ? new_node(tree, left->right->data, outer, inner) : NULL;
+    }
+
+    if (height(right) > height(left) + 1) {
+        if (height(right->right) >= height(right->left)) {
+            /* Perform an RR rotation */
+            replace(tree, right);
+            inner = new_node(tree, data, left, right->left);
+            return inner ? new_node(tree, right->data, inner, right->right) : NULL;
+        }
+
+        /* Perform an RL rotation */
+        replace(tree, right);
+        replace(tree, right->left);
+        inner = new_node(tree, data, left, right->left->left);
+        outer = new_node(tree, right->data, right->left->right, right->right);
+        return outer && inner ? new_node(tree, right->left->data, inner, outer) : NULL;
+    }
+
+    return new_node(tree, data, left, right);
+}
+
+static int insert(PbisTree* tree, const PbisNode* node, const void* data, const PbisNode** result) {
+    const PbisNode* child;
+    int cmpval, retval;
+
+    if (!node) {
+        *result = new_node(tree, data, NULL, NULL);
+        return *result ? 0 : -1;
+    }
+
+    cmpval = tree->compare(data, node->data);
+    if (cmpval == 0) {
+        /* Do nothing since the data is already in the tree */
+        return 1;
+    }
+
+    /* Copy the path down to the new leaf, rebalancing the copies */
+    retval = insert(tree, cmpval < 0 ? node->left : node->right, data, &child);
+    if (retval) {
+        return retval;
+    }
+
+    replace(tree, node);
+    if (cmpval < 0) {
+        *result = balance(tree, node->data, child, node->right);
+    }
+    else {
+        *result = balance(tree, node->data, node->left, child);
+    }
+
+    return *result ? 0 : -1;
+}
+
+static int remove_min(PbisTree* tree, const PbisNode* node, void** min, const PbisNode** result) {
+    const PbisNode* child;
+
+    replace(tree, node);
+
+    if (!node->left) {
+        *min = node->data;
+        *result = node->right;
+        return 0;
+    }
+
+    if (remove_min(tree, node->left, min, &child)) {
+        return -1;
+    }
+
+    *result = balance(tree, node->data, child, node->right);
+    return *result ? 0 : -1;
+}
+
+static int remove_node(PbisTree* tree, const PbisNode* node, const void* data, void** removed, const PbisNode** result) {
+    const PbisNode* child;
+    void* min;
+    int cmpval, retval;
+
+    if (!node) {
+        /* Data not found */
+        return 1;
+    }
+
+    cmpval = tree->compare(data, node->data);
+    if (cmpval != 0) {
+        retval = remove_node(tree, cmpval < 0 ? node->left : node->right, data, removed, &child);
+        if (retval) {
+            return retval;
+        }
+
+        replace(tree, node);
+        if (cmpval < 0) {
+            *result = balance(tree, node->data, child, node->right);
+        }
+        else {
+            *result = balance(tree, node->data, node->left, child);
+        }
+
+        return *result ? 0 : -1;
+    }
+
+    *removed = node->data;
+    replace(tree, node);
+
+    if (!node->left || !node->right) {
+        *result = node->left ? node->left : node->right;
+        return 0;
+    }
+
+    /* Replace the node with the smallest node to its right */
+    if (remove_min(tree, node->right, &min, &child)) {
+        return -1;
+    }
+
+    *result = balance(tree, min, node->left, child);
+    return *result ? 0 : -1;
+}
+
+static void free_garbage(void* data) {
+    PbisGarbage* garbage = data;
+    int i;
+
+    for (i = 0; i < garbage->count; i++) {
+        free((void*) garbage->nodes[i]);
+    }
+
+    free(garbage);
+}
+
+static void destroy_node(PbisTree* tree, const PbisNode* node) {
+    if (!node) {
+        return;
+    }
+
+    destroy_node(tree, node->left);
+    destroy_node(tree, node->right);
+
+    if (tree->destroy) {
+        /* Call a user-defined function to free dynamically allocated data */
+        tree->destroy(node->data);
+    }
+
+    free((void*) node);
+}
+
+static int finish(PbisTree* tree, int retval, const PbisNode* root) {
+    PbisGarbage* garbage;
+    int i;
+
+    garbage = NULL;
+    if (!retval) {
+        garbage = malloc(sizeof(PbisGarbage) + tree->nreplaced * sizeof(PbisNode*));
+        if (!garbage) {
+            retval = -1;
+        }
+    }
+
+    if (retval) {
+        /* Nothing was published, so the new nodes can go straight away */
+        for (i = 0; i < tree->ncreated; i++) {
+            free((void*) tree->created[i]);
+        }
+    }
+    else {
+        /* Publish the new root, then retire the nodes it replaced */
+        atomic_store_explicit(&tree->root, root, memory_order_release);
+
+        garbage->count = tree->nreplaced;
+        memcpy(garbage->nodes, tree->replaced, tree->nreplaced * sizeof(PbisNode*));
+
+        if (epoch_retire(&tree->epoch, garbage, free_garbage)) {
+            /* Leak the old nodes rather than free them under a reader */
+            free(garbage);
+        }
+    }
+
+    tree->ncreated = 0;
+    tree->nreplaced = 0;
+    return retval;
+}
+
+int pbistree_init(PbisTree* tree,
+                  int (*compare)(const void* key1, const void* key2),
+                  void (*destroy)(void* data)) {
+    if (epoch_init(&tree->epoch)) {
+        return -1;
+    }
+
+    pthread_mutex_init(&tree->writer, NULL);
+
+    tree->size = 0;
+    tree->compare = compare;
+    tree->destroy = destroy;
+    tree->ncreated = 0;
+    tree->nreplaced = 0;
+    atomic_init(&tree->root, NULL);
+
+    return 0;
+}
+
+void pbistree_destroy(PbisTree* tree) {
+    /* No readers remain, so retired nodes & data can go too */
+    destroy_node(tree, atomic_load(&tree->root));
+    epoch_destroy(&tree->epoch);
+    pthread_mutex_destroy(&tree->writer);
+}
+
+int pbistree_insert(PbisTree* tree, const void* data) {
+    const PbisNode* root;
+    int retval;
+
+    pthread_mutex_lock(&tree->writer);
+
+    retval = insert(tree, atomic_load_explicit(&tree->root, memory_order_relaxed), data, &root);
+    retval = finish(tree, retval, root);
+    if (!retval) {
+        tree->size += 1;
+    }
+
+    pthread_mutex_unlock(&tree->writer);
+    return retval;
+}
+
+int pbistree_remove(PbisTree* tree, const void* data) {
+    const PbisNode* root;
+    EpochRetired* retired;
+    void* removed;
+    int retval;
+
+    /* Allocate the data's retire record first, so nothing can fail once published */
+    retired = NULL;
+    if (tree->destroy) {
+        retired = malloc(sizeof(EpochRetired));
+        if (!retired) {
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&tree->writer);
+
+    retval = remove_node(tree, atomic_load_explicit(&tree->root, memory_order_relaxed), data, &removed, &root);
+    retval = finish(tree, retval, root);
+    if (!retval) {
+        tree->size -= 1;
+
+        /* Readers of older versions may still hold the data */
+        if (retired) {
+            epoch_retire_record(&tree->epoch, retired, removed, tree->destroy);
+            retired = NULL;
+        }
+    }
+
+    pthread_mutex_unlock(&tree->writer);
+    free(retired);
+    return retval ? -1 : 0;
+}
+
+void pbistree_attach(PbisTree* tree, EpochThread* reader) {
+    epoch_register(&tree->epoch, reader);
+}
+
+void pbistree_detach(PbisTree* tree, EpochThread* reader) {
+    epoch_unregister(&tree->epoch, reader);
+}
+
+const PbisNode* pbistree_pin(PbisTree* tree, EpochThread* reader) {
+    epoch_enter(&tree->epoch, reader);
+    return atomic_load_explicit(&tree->root, memory_order_acquire);
+}
+
+void pbistree_unpin(EpochThread* reader) {
+    epoch_exit(reader);
+}
+
+int pbistree_lookup(const PbisTree* tree, const PbisNode* root, void** data) {
+    const PbisNode* node;
+    int cmpval;
+
+    for (node = root; node; node = cmpval < 0 ? node->left : node->right) {
+        cmpval = tree->compare(*data, node->data);
+
+        if (cmpval == 0) {
+            /* Pass the data back from the snapshot */
+            *data = node->data;
+            return 0;
+        }
+    }
+
+    /* Data not found */
+    return -1;
+}
@@ -0,0 +1,342 @@
+#include "../include/skiplist.h"
+
+/* Links carry a mark in their low bit once the node they leave is being removed */
+#define skip_node(link) ((SkipNode*) ((link) & ~(uintptr_t) 1))
+#define skip_marked(link) ((link) & 1)
+
+static SkipNode* new_node(const void* data, int level) {
+    SkipNode* node;
+    int i;
+
+    node = malloc(sizeof(SkipNode) + level * sizeof(_Atomic(uintptr_t)));
+    if (!node) {
+        return NULL;
+    }
+
+    node->data = (void*) data;
+    node->level = level;
+    atomic_init(&node->state, 0);
+    for (i = 0; i < level; i++) {
+        atomic_init(&node->next[i], 0);
+    }
+
+    return node;
+}
+
+static int random_level(const void* data, const EpochThread* thread) {
+    unsigned long long bits;
+    int level;
+
+    /* Mix the data with the thread, so threads need no shared generator */
+    bits = (uintptr_t) data ^ ((uintptr_t) thread * 0x9e3779b97f4a7c15ULL);
+    bits = (bits ^ (bits >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    bits = (bits ^ (bits >> 27)) * 0x94d049bb133111ebULL;
+    bits ^= bits >> 31;
+
+    /* Each level holds about a quarter of the nodes below it */
+    for (level = 1; level < SKIPLIST_MAX_LEVEL && (bits & 3) == 0; level++) {
+        bits >>= 2;
+    }
+
+    return level;
+}
+
+static int find(SkipList* list, const void* data, SkipNode** preds, SkipNode** succs) {
+    SkipNode* pred;
+    SkipNode* curr;
+    uintptr_t succ, expected;
+    int level;
+
+retry:
+    pred = list->head;
+
+    for (level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--) {
+        curr = skip_node(atomic_load(&pred->next[level]));
+
+        while (curr) {
+            /* Unlink nodes marked for removal as they are passed */
+            succ = atomic_load(&curr->next[level]);
+            while (skip_marked(succ)) {
+                expected = (uintptr_t) curr;
+                if (!atomic_compare_exchange_strong(&pred->next[level], &expected, (uintptr_t) skip_node(succ))) {
+                    goto retry;
+                }
+
+                curr = skip_node(succ);
+                if (!curr) {
+                    break;
+                }
+
+                succ = atomic_load(&curr->next[level]);
+            }
+
+            if (!curr || list->compare(curr->data, data) >= 0) {
+                break;
+            }
+
+            pred = curr;
+            curr = skip_node(succ);
+        }
+
+        preds[level] = pred;
+        succs[level] = curr;
+    }
+
+    return succs[0] && list->compare(succs[0]->data, data) == 0;
+}
+
+static void retire(SkipList* list, SkipNode* node) {
+    SkipNode* preds[SKIPLIST_MAX_LEVEL];
+    SkipNode* succs[SKIPLIST_MAX_LEVEL];
+
+    /* Search once more to unlink the node at every level, then free it once no thread can hold it */
+    find(list, node->data, preds, succs);
+
+    if (list->destroy) {
+        epoch_retire(&list->epoch, node->data, list->destroy);
+    }
+
+    epoch_retire(&list->epoch, node, free);
+}
+
+int skiplist_init(SkipList* list,
+                  int (*compare)(const void* key1, const void* key2),
+                  void (*destroy)(void* data)) {
+    list->head = new_node(NULL, SKIPLIST_MAX_LEVEL);
+    if (!list->head) {
+        return -1;
+    }
+
+    if (epoch_init(&list->epoch)) {
+        free(list->head);
+        return -1;
+    }
+
+    atomic_init(&list->size, 0);
+    list->compare = compare;
+    list->destroy = destroy;
+
+    return 0;
+}
+
+void skiplist_destroy(SkipList* list) {
+    SkipNode* node;
+    SkipNode* next;
+
+    /* No other thread remains, so everything still linked can go at once */
+    for (node = skip_node(atomic_load(&list->head->next[0])); node; node = next) {
+        next = skip_node(atomic_load(&node->next[0]));
+
+        if (list->destroy) {
+            list->destroy(node->data);
+        }
+
+        free(node);
+    }
+
+    free(list->head);
+    epoch_destroy(&list->epoch);
+}
+
+void skiplist_attach(SkipList* list, EpochThread* thread) {
+    epoch_register(&list->epoch, thread);
+}
+
+void skiplist_detach(SkipList* list, EpochThread* thread) {
+    epoch_unregister(&list->epoch, thread);
+}
+
+static int enter(SkipList* list, EpochThread* thread) {
+    /* A thread the caller already pinned stays pinned, so what it finds stays valid */
+    if (atomic_load_explicit(&thread->epoch, memory_order_relaxed) != EPOCH_IDLE) {
+        return 0;
+    }
+
+    epoch_enter(&list->epoch, thread);
+    return 1;
+}
+
+static void leave(EpochThread* thread, int pinned) {
+    if (pinned) {
+        epoch_exit(thread);
+    }
+}
+
+int skiplist_insert(SkipList* list, EpochThread* thread, const void* data) {
+    SkipNode* preds[SKIPLIST_MAX_LEVEL];
+    SkipNode* succs[SKIPLIST_MAX_LEVEL];
+    SkipNode* node;
+    uintptr_t expected, link;
+    int pinned, level;
+
+    node = new_node(data, random_level(data, thread));
+    if (!node) {
+        return -1;
+    }
+
+    pinned = enter(list, thread);
+
+    /* Link in the bottom level first, which is what makes the data present */
+    do {
+        if (find(list, data, preds, succs)) {
+            /* Do nothing since the data is already in the list */
+            leave(thread, pinned);
+            free(node);
+            return 1;
+        }
+
+        atomic_store(&node->next[0], (uintptr_t) succs[0]);
+        expected = (uintptr_t) succs[0];
+    } while (!atomic_compare_exchange_strong(&preds[0]->next[0], &expected, (uintptr_t) node));
+
+    atomic_fetch_add(&list->size, 1);
+
+    /* Then link each level above, stopping early if the node is already being removed */
+    for (level = 1; level < node->level; level++) {
+        for (;;) {
+            link = atomic_load(&node->next[level]);
+            if (skip_marked(link)) {
+                break;
+            }
+
+            if (link != (uintptr_t) succs[level]
+                && !atomic_compare_exchange_strong(&node->next[level], &link, (uintptr_t) succs[level])) {
+                break;
+            }
+
+            expected = (uintptr_t) succs[level];
+            if (atomic_compare_exchange_strong(&preds[level]->next[level], &expected, (uintptr_t) node)) {
+                break;
+            }
+
+            find(list, data, preds, succs);
+        }
+
+        if (skip_marked(atomic_load(&node->next[level]))) {
+            break;
+        }
+    }
+
+    /* A remover that came first left the node for us to retire */
+    if (atomic_fetch_or(&node->state, SKIPLIST_LINKED) & SKIPLIST_REMOVED) {
+        retire(list, node);
+    }
+
+    leave(thread, pinned);
+    return 0;
+}
+
+int skiplist_remove(SkipList* list, EpochThread* thread, const void* data) {
+    SkipNode* preds[SKIPLIST_MAX_LEVEL];
+    SkipNode* succs[SKIPLIST_MAX_LEVEL];
+    SkipNode* node;
+    uintptr_t link;
+    int pinned, level;
+
+    pinned = enter(list, thread);
+
+    if (!find(list, data, preds, succs)) {
+        /* Data not found */
+        leave(thread, pinned);
+        return -1;
+    }
+
+    node = succs[0];
+
+    /* Mark the upper levels top down so no new links are made there */
+    for (level = node->level - 1; level > 0; level--) {
+        link = atomic_load(&node->next[level]);
+        while (!skip_marked(link) && !atomic_compare_exchange_weak(&node->next[level], &link, link | 1)) {
+            continue;
+        }
+    }
+
+    /* Marking the bottom level removes the data, & only one thread can do it */
+    link = atomic_load(&node->next[0]);
+    for (;;) {
+        if (skip_marked(link)) {
+            /* Another thread removed it first */
+            leave(thread, pinned);
+            return -1;
+        }
+
+        if (atomic_compare_exchange_weak(&node->next[0], &link, link | 1)) {
+            break;
+        }
+    }
+
+    atomic_fetch_sub(&list->size, 1);
+
+    /* A node still being linked is left for its inserter to retire */
+    if (atomic_fetch_or(&node->state, SKIPLIST_REMOVED) & SKIPLIST_LINKED) {
+        retire(list, node);
+    }
+
+    leave(thread, pinned);
+    return 0;
+}
+
+int skiplist_lookup(SkipList* list, EpochThread* thread, void** data) {
+    const SkipNode* node;
+    int pinned, retval;
+
+    pinned = enter(list, thread);
+
+    node = skiplist_seek(list, *data);
+    if (node && list->compare(node->data, *data) == 0) {
+        /* Pass the data back from the list */
+        *data = node->data;
+        retval = 0;
+    }
+    else {
+        /* Data not found */
+        retval = -1;
+    }
+
+    leave(thread, pinned);
+    return retval;
+}
+
+void skiplist_pin(SkipList* list, EpochThread* thread) {
+    epoch_enter(&list->epoch, thread);
+}
+
+void skiplist_unpin(EpochThread* thread) {
+    epoch_exit(thread);
+}
+
+const SkipNode* skiplist_seek(const SkipList* list, const void* data) {
+    const SkipNode* pred;
+    const SkipNode* curr;
+    int level;
+
+    /* Readers step over removed nodes without unlinking them, & no data means the first node */
+    pred = list->head;
+    for (level = data ? SKIPLIST_MAX_LEVEL - 1 : -1; level >= 0; level--) {
+        curr = skip_node(atomic_load(&pred->next[level]));
+
+        while (curr && list->compare(curr->data, data) < 0) {
+            pred = curr;
+            curr = skip_node(atomic_load(&curr->next[level]));
+        }
+    }
+
+    /* Find the first node at or after the data that is still present */
+    curr = skip_node(atomic_load(&pred->next[0]));
+    while (curr && skip_marked(atomic_load(&curr->next[0]))) {
+        curr = skip_node(atomic_load(&curr->next[0]));
+    }
+
+    return curr;
+}
+
+const SkipNode* skiplist_next(const SkipNode* node) {
+    const SkipNode* next;
+
+    next = skip_node(atomic_load(&node->next[0]));
+    while (next && skip_marked(atomic_load(&next->next[0]))) {
+        next = skip_node(atomic_load(&next->next[0]));
+    }
+
+    return next;
+}
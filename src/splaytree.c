@@ -0,0 +1,194 @@
+#include <string.h>
+#include "../include/splaytree.h"
+
+static int splay(SplayTree* tree, const void* data) {
+    BiTreeNode header;
+    BiTreeNode* left;
+    BiTreeNode* right;
+    BiTreeNode* node;
+    BiTreeNode* child;
+    int cmpval, next;
+
+    /* Split the tree top down into nodes less than & greater than the data */
+    header.left = NULL;
+    header.right = NULL;
+    left = &header;
+    right = &header;
+    node = bitree_root(tree);
+    cmpval = tree->compare(data, bitree_data(node));
+
+    /* Each comparison is made once, the one with a child carried down to it */
+    while (cmpval != 0) {
+        child = cmpval < 0 ? bitree_left(node) : bitree_right(node);
+        if (bitree_is_eob(child)) {
+            break;
+        }
+
+        next = tree->compare(data, bitree_data(child));
+
+        if (cmpval < 0) {
+            if (next < 0) {
+                /* Rotate right before going two steps left */
+                bitree_left(node) = bitree_right(child);
+                bitree_right(child) = node;
+                node = child;
+
+                if (bitree_is_eob(bitree_left(node))) {
+                    break;
+                }
+
+                child = bitree_left(node);
+                next = tree->compare(data, bitree_data(child));
+            }
+
+            /* Hang the node off the greater side */
+            bitree_left(right) = node;
+            right = node;
+        }
+        else {
+            if (next > 0) {
+                /* Rotate left before going two steps right */
+                bitree_right(node) = bitree_left(child);
+                bitree_left(child) = node;
+                node = child;
+
+                if (bitree_is_eob(bitree_right(node))) {
+                    break;
+                }
+
+                child = bitree_right(node);
+                next = tree->compare(data, bitree_data(child));
+            }
+
+            /* Hang the node off the lesser side */
+            bitree_right(left) = node;
+            left = node;
+        }
+
+        node = child;
+        cmpval = next;
+    }
+
+    /* Put the two sides back together under the last node reached */
+    bitree_right(left) = bitree_left(node);
+    bitree_left(right) = bitree_right(node);
+    bitree_left(node) = bitree_right(&header);
+    bitree_right(node) = bitree_left(&header);
+    bitree_root(tree) = node;
+
+    return cmpval;
+}
+
+void splaytree_init(SplayTree* tree,
+                    int (*compare)(const void* key1, const void* key2),
+                    void (*destroy)(void* data)) {
+    bitree_init(tree, destroy);
+    tree->compare = compare;
+}
+
+void splaytree_destroy(SplayTree* tree) {
+    BiTreeNode* node;
+    BiTreeNode* left;
+
+    /* Rotate left children up so the tree comes apart as a list, however deep it is */
+    node = bitree_root(tree);
+    while (!bitree_is_eob(node)) {
+        left = bitree_left(node);
+
+        if (!bitree_is_eob(left)) {
+            bitree_left(node) = bitree_right(left);
+            bitree_right(left) = node;
+            node = left;
+            continue;
+        }
+
+        left = bitree_right(node);
+        if (tree->destroy) {
+            /* Call a user-defined function to free dynamically allocated data */
+            tree->destroy(bitree_data(node));
+        }
+
+        free(node);
+        node = left;
+    }
+
+    memset(tree, 0, sizeof(SplayTree));
+}
+
+int splaytree_insert(SplayTree* tree, const void* data) {
+    BiTreeNode* new_node;
+    int cmpval;
+
+    cmpval = 0;
+    if (!bitree_is_eob(bitree_root(tree))) {
+        cmpval = splay(tree, data);
+        if (cmpval == 0) {
+            /* Do nothing since the data is already in the tree */
+            return 1;
+        }
+    }
+
+    new_node = (BiTreeNode*) malloc(sizeof(BiTreeNode));
+    if (!new_node) {
+        return -1;
+    }
+
+    /* Split the old root's subtrees around the new node */
+    new_node->data = (void*) data;
+    new_node->left = NULL;
+    new_node->right = NULL;
+
+    if (cmpval < 0) {
+        new_node->left = bitree_left(bitree_root(tree));
+        new_node->right = bitree_root(tree);
+        bitree_left(bitree_root(tree)) = NULL;
+    }
+    else if (cmpval > 0) {
+        new_node->right = bitree_right(bitree_root(tree));
+        new_node->left = bitree_root(tree);
+        bitree_right(bitree_root(tree)) = NULL;
+    }
+
+    bitree_root(tree) = new_node;
+    tree->size += 1;
+
+    return 0;
+}
+
+int splaytree_remove(SplayTree* tree, void** data) {
+    BiTreeNode* old_node;
+
+    if (bitree_is_eob(bitree_root(tree)) || splay(tree, *data) != 0) {
+        /* Data not found */
+        return -1;
+    }
+
+    /* Pass the data back & join the two subtrees under the greatest node on the left */
+    old_node = bitree_root(tree);
+    *data = bitree_data(old_node);
+
+    if (bitree_is_eob(bitree_left(old_node))) {
+        bitree_root(tree) = bitree_right(old_node);
+    }
+    else {
+        bitree_root(tree) = bitree_left(old_node);
+        splay(tree, *data);
+        bitree_right(bitree_root(tree)) = bitree_right(old_node);
+    }
+
+    free(old_node);
+    tree->size -= 1;
+
+    return 0;
+}
+
+int splaytree_lookup(SplayTree* tree, void** data) {
+    if (bitree_is_eob(bitree_root(tree)) || splay(tree, *data) != 0) {
+        /* Data not found */
+        return -1;
+    }
+
+    /* Pass the data back from the tree */
+    *data = bitree_data(bitree_root(tree));
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <string.h>
+#include "../include/parallel.h"
+#include "../include/triangle.h"
+
+/* Vertices handed to a thread at a time */
+#define TRIANGLE_GRAIN 256
+
+/* Longs per per-thread total, padded to a cache line */
+#define TRIANGLE_STRIDE 8
+
+typedef struct {
+    const CsrGraph* dag;
+    long* per_vertex;
+    long* totals;
+    int* scratch;
+    int maxdeg;
+} Count;
+
+static int orient(CsrGraph* dag, const CsrGraph* csr) {
+    const int* adj;
+    int* degree;
+    int* edges;
+    int ecount, u, v, i, rc;
+
+    degree = calloc(csr_vcount(csr) ? csr_vcount(csr) : 1, sizeof(int));
+    edges = malloc(2 * ((size_t) csr_ecount(csr) + 1) * sizeof(int));
+    if (!degree || !edges) {
+        free(degree);
+        free(edges);
+        return -1;
+    }
+
+    /* Rank vertices by their degree with the edges taken as undirected */
+    for (u = 0; u < csr_vcount(csr); u++) {
+        adj = csr_neighbours(csr, u);
+        degree[u] += csr_degree(csr, u);
+
+        for (i = 0; i < csr_degree(csr, u); i++) {
+            degree[adj[i]] += 1;
+        }
+    }
+
+    /* Point every edge from the lower to the higher ranked vertex */
+    ecount = 0;
+    for (u = 0; u < csr_vcount(csr); u++) {
+        adj = csr_neighbours(csr, u);
+
+        for (i = 0; i < csr_degree(csr, u); i++) {
+            v = adj[i];
+            if (u == v) {
+                continue; /* self loops close no triangles */
+            }
+
+            if (degree[u] < degree[v] || (degree[u] == degree[v] && u < v)) {
+                edges[2 * ecount] = u;
+                edges[2 * ecount + 1] = v;
+            }
+            else {
+                edges[2 * ecount] = v;
+                edges[2 * ecount + 1] = u;
+            }
+
+            ecount++;
+        }
+    }
+
+    /* Building the frozen graph also drops edges present in both directions */
+    rc = csr_from_edges(dag, csr_vcount(csr), edges, ecount);
+
+    free(degree);
+    free(edges);
+    return rc;
+}
+
+static void count_rows(int begin, int end, int thread, void* arg) {
+    const Count* count = arg;
+    const CsrGraph* dag = count->dag;
+    const int* adj;
+    int* common;
+    long total;
+    int found, u, v, i, k;
+
+    common = count->per_vertex ? count->scratch + (size_t) thread * count->maxdeg : NULL;
+    total = 0;
+
+    /* Each triangle is found once, from its lowest ranked corner */
+    for (u = begin; u < end; u++) {
+        adj = csr_neighbours(dag, u);
+
+        for (i = 0; i < csr_degree(dag, u); i++) {
+            v = adj[i];
+            found = csr_intersect(adj, csr_degree(dag, u), csr_neighbours(dag, v), csr_degree(dag, v), common);
+            total += found;
+
+            if (!common || !found) {
+                continue;
+            }
+
+            /* Credit all three corners of every triangle found */
+            __atomic_fetch_add(&count->per_vertex[u], found, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&count->per_vertex[v], found, __ATOMIC_RELAXED);
+
+            for (k = 0; k < found; k++) {
+                __atomic_fetch_add(&count->per_vertex[common[k]], 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    count->totals[thread * TRIANGLE_STRIDE] += total;
+}
+
+long triangle_count(const CsrGraph* csr, int nthreads, long* per_vertex) {
+    CsrGraph dag;
+    Count count;
+    long total;
+    int v, t;
+
+    if (orient(&dag, csr)) {
+        return -1;
+    }
+
+    nthreads = parallel_threads(nthreads);
+
+    count.dag = &dag;
+    count.per_vertex = per_vertex;
+    count.maxdeg = 1;
+    for (v = 0; v < csr_vcount(&dag); v++) {
+        if (csr_degree(&dag, v) > count.maxdeg) {
+            count.maxdeg = csr_degree(&dag, v);
+        }
+    }
+
+    /* Only per-vertex counts need the members of each intersection */
+    count.totals = calloc((size_t) nthreads * TRIANGLE_STRIDE, sizeof(long));
+    count.scratch = per_vertex ? malloc((size_t) nthreads * count.maxdeg * sizeof(int)) : NULL;
+    if (!count.totals || (per_vertex && !count.scratch)) {
+        free(count.totals);
+        free(count.scratch);
+        csr_destroy(&dag);
+        return -1;
+    }
+
+    if (per_vertex) {
+        memset(per_vertex, 0, csr_vcount(csr) * sizeof(long));
+    }
+
+    parallel_for(csr_vcount(&dag), TRIANGLE_GRAIN, nthreads, count_rows, &count);
+
+    total = 0;
+    for (t = 0; t < nthreads; t++) {
+        total += count.totals[t * TRIANGLE_STRIDE];
+    }
+
+    free(count.totals);
+    free(count.scratch);
+    csr_destroy(&dag);
+    return total;
+}
@@ -0,0 +1,259 @@
+#include <string.h>
+#include "../include/tst.h"
+
+/* Index 0 is the root, so no link can point back to it & 0 can mean none */
+#define TST_NONE 0
+
+static int new_node(Tst* tst, unsigned char split) {
+    TstNode* nodes;
+    int capacity;
+
+    if (tst->count == tst->capacity) {
+        /* Grow the node array, every link being an index that stays valid */
+        capacity = tst->capacity ? 2 * tst->capacity : 64;
+        nodes = realloc(tst->nodes, capacity * sizeof(TstNode));
+        if (!nodes) {
+            return -1;
+        }
+
+        tst->nodes = nodes;
+        tst->capacity = capacity;
+    }
+
+    memset(&tst->nodes[tst->count], 0, sizeof(TstNode));
+    tst->nodes[tst->count].split = split;
+    return tst->count++;
+}
+
+static int find(const Tst* tst, const char* key) {
+    const TstNode* node;
+    int index;
+
+    if (!tst->count || !*key) {
+        return -1;
+    }
+
+    /* Go sideways on a mismatch & down on a match */
+    index = 0;
+    for (;;) {
+        node = &tst->nodes[index];
+
+        if ((unsigned char) *key < node->split) {
+            index = node->low;
+        }
+        else if ((unsigned char) *key > node->split) {
+            index = node->high;
+        }
+        else if (*++key) {
+            index = node->equal;
+        }
+        else {
+            return index;
+        }
+
+        if (index == TST_NONE) {
+            return -1;
+        }
+    }
+}
+
+static int walk(const Tst* tst, int index, int (*callback)(const void* data, void* arg), void* arg) {
+    const TstNode* node;
+
+    /* Recurse below & into each node, but loop along the higher side */
+    do {
+        node = &tst->nodes[index];
+
+        if (node->low != TST_NONE && walk(tst, node->low, callback, arg)) {
+            return 1;
+        }
+
+        if (node->end && callback(node->data, arg)) {
+            return 1;
+        }
+
+        if (node->equal != TST_NONE && walk(tst, node->equal, callback, arg)) {
+            return 1;
+        }
+
+        index = node->high;
+    } while (index != TST_NONE);
+
+    return 0;
+}
+
+void tst_init(Tst* tst, void (*destroy)(void* data)) {
+    tst->size = 0;
+    tst->count = 0;
+    tst->capacity = 0;
+    tst->destroy = destroy;
+    tst->nodes = NULL;
+}
+
+void tst_destroy(Tst* tst) {
+    int i;
+
+    if (tst->destroy) {
+        for (i = 0; i < tst->count; i++) {
+            if (tst->nodes[i].end) {
+                /* Call a user-defined function to free dynamically allocated data */
+                tst->destroy(tst->nodes[i].data);
+            }
+        }
+    }
+
+    free(tst->nodes);
+    memset(tst, 0, sizeof(Tst));
+}
+
+static int* link_of(Tst* tst, int index, int side) {
+    return side < 0 ? &tst->nodes[index].low : side > 0 ? &tst->nodes[index].high : &tst->nodes[index].equal;
+}
+
+int tst_insert(Tst* tst, const char* key, const void* data) {
+    int index, next, side;
+
+    if (!*key) {
+        return -1;
+    }
+
+    if (!tst->count && new_node(tst, (unsigned char) *key) < 0) {
+        return -1;
+    }
+
+    /* Follow the key as far as it goes, then add a node for each character left */
+    index = 0;
+    for (;;) {
+        side = (unsigned char) *key - tst->nodes[index].split;
+        if (side == 0) {
+            if (!key[1]) {
+                break;
+            }
+
+            key++;
+        }
+
+        next = *link_of(tst, index, side);
+        if (next == TST_NONE) {
+            next = new_node(tst, (unsigned char) *key);
+            if (next < 0) {
+                return -1;
+            }
+
+            /* Growing the array may have moved the link, so look it up again */
+            *link_of(tst, index, side) = next;
+        }
+
+        index = next;
+    }
+
+    if (tst->nodes[index].end) {
+        /* Do nothing since the key is already in the index */
+        return 1;
+    }
+
+    tst->nodes[index].end = 1;
+    tst->nodes[index].data = (void*) data;
+    tst->size += 1;
+
+    return 0;
+}
+
+int tst_remove(Tst* tst, const char* key, void** data) {
+    int index;
+
+    index = find(tst, key);
+    if (index < 0 || !tst->nodes[index].end) {
+        /* Key not found */
+        return -1;
+    }
+
+    /* The nodes stay, as other keys may pass through them */
+    *data = tst->nodes[index].data;
+    tst->nodes[index].end = 0;
+    tst->nodes[index].data = NULL;
+    tst->size -= 1;
+
+    return 0;
+}
+
+int tst_lookup(const Tst* tst, const char* key, void** data) {
+    int index;
+
+    index = find(tst, key);
+    if (index < 0 || !tst->nodes[index].end) {
+        /* Key not found */
+        return -1;
+    }
+
+    /* Pass the data back from the index */
+    *data = tst->nodes[index].data;
+    return 0;
+}
+
+int tst_longest_prefix(const Tst* tst, const char* key, void** data) {
+    const TstNode* node;
+    int index, length, longest;
+
+    if (!tst->count) {
+        return -1;
+    }
+
+    /* Remember the last key ending along the way */
+    longest = -1;
+    length = 0;
+    index = 0;
+    while (*key) {
+        node = &tst->nodes[index];
+
+        if ((unsigned char) *key < node->split) {
+            index = node->low;
+        }
+        else if ((unsigned char) *key > node->split) {
+            index = node->high;
+        }
+        else {
+            length++;
+            key++;
+
+            if (node->end) {
+                longest = length;
+                *data = node->data;
+            }
+
+            index = node->equal;
+        }
+
+        if (index == TST_NONE) {
+            break;
+        }
+    }
+
+    return longest;
+}
+
+int tst_prefix(const Tst* tst, const char* prefix,
+               int (*callback)(const void* data, void* arg), void* arg) {
+    int index;
+
+    if (!*prefix) {
+        /* Every key starts with the empty prefix */
+        return tst->count ? walk(tst, 0, callback, arg) : 0;
+    }
+
+    index = find(tst, prefix);
+    if (index < 0) {
+        return 0;
+    }
+
+    /* The prefix itself comes first, then every key that extends it */
+    if (tst->nodes[index].end && callback(tst->nodes[index].data, arg)) {
+        return 1;
+    }
+
+    if (tst->nodes[index].equal == TST_NONE) {
+        return 0;
+    }
+
+    return walk(tst, tst->nodes[index].equal, callback, arg);
+}
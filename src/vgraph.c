@@ -0,0 +1,349 @@
+#include <string.h>
+#include "../include/vgraph.h"
+
+static VGraphAdj* new_adj(void* vertex, int degree) {
+    VGraphAdj* adj;
+
+    adj = malloc(sizeof(VGraphAdj) + degree * sizeof(int));
+    if (!adj) {
+        return NULL;
+    }
+
+    adj->vertex = vertex;
+    adj->degree = degree;
+    return adj;
+}
+
+static void free_version(void* data) {
+    VGraphVersion* version = data;
+
+    /* Chunks & adjacency records are shared with newer versions */
+    free(version->chunks);
+    free(version);
+}
+
+static int publish(VGraph* vgraph, VGraphVersion* old, int v, VGraphAdj* adj, int ecount) {
+    VGraphVersion* version;
+    VGraphChunk** chunks;
+    VGraphChunk* chunk;
+    VGraphChunk* old_chunk;
+    VGraphAdj* old_adj;
+    EpochRetired* retired[3];
+    int c, nchunks, i;
+
+    c = v / VGRAPH_CHUNK;
+    nchunks = c < old->nchunks ? old->nchunks : c + 1;
+
+    version = malloc(sizeof(VGraphVersion));
+    chunks = malloc(nchunks * sizeof(VGraphChunk*));
+    chunk = malloc(sizeof(VGraphChunk));
+
+    /* Allocate the retire records up front so nothing can fail once published */
+    for (i = 0; i < 3; i++) {
+        retired[i] = malloc(sizeof(EpochRetired));
+    }
+
+    if (!version || !chunks || !chunk || !retired[0] || !retired[1] || !retired[2]) {
+        free(version);
+        free(chunks);
+        free(chunk);
+        for (i = 0; i < 3; i++) {
+            free(retired[i]);
+        }
+        return -1;
+    }
+
+    /* Copy the chunk directory & the one chunk that changes */
+    memcpy(chunks, old->chunks, old->nchunks * sizeof(VGraphChunk*));
+
+    if (c < old->nchunks) {
+        old_chunk = old->chunks[c];
+        memcpy(chunk, old_chunk, sizeof(VGraphChunk));
+        old_adj = chunk->adj[v % VGRAPH_CHUNK];
+    }
+    else {
+        old_chunk = NULL;
+        memset(chunk, 0, sizeof(VGraphChunk));
+        old_adj = NULL;
+    }
+
+    chunk->adj[v % VGRAPH_CHUNK] = adj;
+    chunks[c] = chunk;
+
+    version->vcount = v < old->vcount ? old->vcount : v + 1;
+    version->ecount = ecount;
+    version->nchunks = nchunks;
+    version->chunks = chunks;
+
+    /* Publish the new version, then retire whatever it replaced */
+    atomic_store_explicit(&vgraph->current, version, memory_order_release);
+
+    epoch_retire_record(&vgraph->epoch, retired[0], old, free_version);
+
+    if (old_chunk) {
+        epoch_retire_record(&vgraph->epoch, retired[1], old_chunk, free);
+    }
+    else {
+        free(retired[1]);
+    }
+
+    if (old_adj) {
+        epoch_retire_record(&vgraph->epoch, retired[2], old_adj, free);
+    }
+    else {
+        free(retired[2]);
+    }
+
+    return 0;
+}
+
+int vgraph_init(VGraph* vgraph, const CsrGraph* csr) {
+    VGraphVersion* version;
+    VGraphAdj* adj;
+    int nchunks, c, v;
+
+    nchunks = (csr_vcount(csr) + VGRAPH_CHUNK - 1) / VGRAPH_CHUNK;
+
+    if (epoch_init(&vgraph->epoch)) {
+        return -1;
+    }
+
+    pthread_mutex_init(&vgraph->writer, NULL);
+
+    version = malloc(sizeof(VGraphVersion));
+    if (!version) {
+        epoch_destroy(&vgraph->epoch);
+        pthread_mutex_destroy(&vgraph->writer);
+        return -1;
+    }
+
+    version->vcount = csr_vcount(csr);
+    version->ecount = csr_ecount(csr);
+    version->nchunks = nchunks;
+    version->chunks = calloc(nchunks ? nchunks : 1, sizeof(VGraphChunk*));
+    if (!version->chunks) {
+        free(version);
+        epoch_destroy(&vgraph->epoch);
+        pthread_mutex_destroy(&vgraph->writer);
+        return -1;
+    }
+
+    atomic_init(&vgraph->current, version);
+
+    /* Copy each vertex's neighbours into its own adjacency record */
+    for (c = 0; c < nchunks; c++) {
+        version->chunks[c] = calloc(1, sizeof(VGraphChunk));
+        if (!version->chunks[c]) {
+            vgraph_destroy(vgraph);
+            return -1;
+        }
+    }
+
+    for (v = 0; v < csr_vcount(csr); v++) {
+        adj = new_adj(csr_vertex(csr, v), csr_degree(csr, v));
+        if (!adj) {
+            vgraph_destroy(vgraph);
+            return -1;
+        }
+
+        memcpy(adj->targets, csr_neighbours(csr, v), adj->degree * sizeof(int));
+        vgraph_adj(version, v) = adj;
+    }
+
+    return 0;
+}
+
+void vgraph_destroy(VGraph* vgraph) {
+    VGraphVersion* version;
+    int c, i;
+
+    version = atomic_load(&vgraph->current);
+
+    /* The current version owns every chunk & record it refers to */
+    for (c = 0; c < version->nchunks; c++) {
+        if (!version->chunks[c]) {
+            continue;
+        }
+
+        for (i = 0; i < VGRAPH_CHUNK; i++) {
+            free(version->chunks[c]->adj[i]);
+        }
+
+        free(version->chunks[c]);
+    }
+
+    free_version(version);
+
+    epoch_destroy(&vgraph->epoch);
+    pthread_mutex_destroy(&vgraph->writer);
+    memset(vgraph, 0, sizeof(VGraph));
+}
+
+int vgraph_ins_vertex(VGraph* vgraph, const void* data) {
+    VGraphVersion* old;
+    VGraphAdj* adj;
+    int id;
+
+    pthread_mutex_lock(&vgraph->writer);
+
+    old = atomic_load_explicit(&vgraph->current, memory_order_relaxed);
+    id = old->vcount;
+
+    adj = new_adj((void*) data, 0);
+    if (!adj || publish(vgraph, old, id, adj, old->ecount)) {
+        free(adj);
+        id = -1;
+    }
+
+    pthread_mutex_unlock(&vgraph->writer);
+    return id;
+}
+
+int vgraph_ins_edge(VGraph* vgraph, int id1, int id2) {
+    VGraphVersion* old;
+    VGraphAdj* old_adj;
+    VGraphAdj* adj;
+    int rc, i;
+
+    pthread_mutex_lock(&vgraph->writer);
+
+    old = atomic_load_explicit(&vgraph->current, memory_order_relaxed);
+
+    /* Don't allow insertion of an edge without both its vertices in the graph */
+    if (id1 < 0 || id1 >= old->vcount || id2 < 0 || id2 >= old->vcount) {
+        pthread_mutex_unlock(&vgraph->writer);
+        return -1;
+    }
+
+    old_adj = vgraph_adj(old, id1);
+
+    for (i = 0; i < old_adj->degree; i++) {
+        if (old_adj->targets[i] == id2) {
+            /* Do nothing since the edge is already in the graph */
+            pthread_mutex_unlock(&vgraph->writer);
+            return 1;
+        }
+    }
+
+    /* Copy the adjacency record of the 1st vertex & append the 2nd */
+    rc = -1;
+    adj = new_adj(old_adj->vertex, old_adj->degree + 1);
+    if (adj) {
+        memcpy(adj->targets, old_adj->targets, old_adj->degree * sizeof(int));
+        adj->targets[old_adj->degree] = id2;
+
+        rc = publish(vgraph, old, id1, adj, old->ecount + 1);
+        if (rc) {
+            free(adj);
+        }
+    }
+
+    pthread_mutex_unlock(&vgraph->writer);
+    return rc;
+}
+
+int vgraph_rem_edge(VGraph* vgraph, int id1, int id2) {
+    VGraphVersion* old;
+    VGraphAdj* old_adj;
+    VGraphAdj* adj;
+    int rc, i, j;
+
+    pthread_mutex_lock(&vgraph->writer);
+
+    old = atomic_load_explicit(&vgraph->current, memory_order_relaxed);
+
+    if (id1 < 0 || id1 >= old->vcount) {
+        pthread_mutex_unlock(&vgraph->writer);
+        return -1;
+    }
+
+    old_adj = vgraph_adj(old, id1);
+
+    for (i = 0; i < old_adj->degree; i++) {
+        if (old_adj->targets[i] == id2) {
+            break;
+        }
+    }
+
+    if (i == old_adj->degree) {
+        pthread_mutex_unlock(&vgraph->writer);
+        return -1;
+    }
+
+    /* Copy the adjacency record of the 1st vertex without the 2nd */
+    rc = -1;
+    adj = new_adj(old_adj->vertex, old_adj->degree - 1);
+    if (adj) {
+        for (i = 0, j = 0; i < old_adj->degree; i++) {
+            if (old_adj->targets[i] != id2) {
+                adj->targets[j++] = old_adj->targets[i];
+            }
+        }
+
+        rc = publish(vgraph, old, id1, adj, old->ecount - 1);
+        if (rc) {
+            free(adj);
+        }
+    }
+
+    pthread_mutex_unlock(&vgraph->writer);
+    return rc;
+}
+
+void vgraph_attach(VGraph* vgraph, EpochThread* reader) {
+    epoch_register(&vgraph->epoch, reader);
+}
+
+void vgraph_detach(VGraph* vgraph, EpochThread* reader) {
+    epoch_unregister(&vgraph->epoch, reader);
+}
+
+const VGraphVersion* vgraph_pin(VGraph* vgraph, EpochThread* reader) {
+    epoch_enter(&vgraph->epoch, reader);
+    return atomic_load_explicit(&vgraph->current, memory_order_acquire);
+}
+
+void vgraph_unpin(EpochThread* reader) {
+    epoch_exit(reader);
+}
+
+int vgraph_bfs(const VGraphVersion* version, int start, int* hops) {
+    const VGraphAdj* adj;
+    int* queue;
+    int head, tail, u, i;
+
+    if (start < 0 || start >= vgraph_vcount(version)) {
+        return -1;
+    }
+
+    queue = malloc(vgraph_vcount(version) * sizeof(int));
+    if (!queue) {
+        return -1;
+    }
+
+    /* Unreached vertices keep a hop count of -1 */
+    for (i = 0; i < vgraph_vcount(version); i++) {
+        hops[i] = -1;
+    }
+
+    hops[start] = 0;
+    queue[0] = start;
+    head = 0;
+    tail = 1;
+
+    /* Perform a breadth-first search over the pinned snapshot */
+    while (head < tail) {
+        u = queue[head++];
+        adj = vgraph_adj(version, u);
+
+        for (i = 0; i < adj->degree; i++) {
+            if (hops[adj->targets[i]] < 0) {
+                hops[adj->targets[i]] = hops[u] + 1;
+                queue[tail++] = adj->targets[i];
+            }
+        }
+    }
+
+    free(queue);
+    return 0;
+}